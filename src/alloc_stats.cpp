@@ -0,0 +1,181 @@
+#include "alloc_stats.h"
+
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace aoc {
+
+  namespace {
+
+    // Plain data so the hooks never trigger thread_local construction (which could itself allocate)
+    struct thread_alloc_counters_t {
+      bool _active;
+      uint64_t _allocations;
+      uint64_t _deallocations;
+      uint64_t _bytes;
+      int64_t _live_bytes;
+      int64_t _peak_live_bytes;
+    };
+
+    thread_local thread_alloc_counters_t thread_counters;
+
+  } // namespace
+
+#ifdef AOC_ALLOC_STATS
+
+  namespace {
+
+    void record_allocation(void *pointer) {
+      auto &counters = thread_counters;
+      if (!counters._active || pointer == nullptr) return;
+      auto size = static_cast<int64_t>(malloc_usable_size(pointer));
+      counters._allocations++;
+      counters._bytes += size;
+      counters._live_bytes += size;
+      if (counters._live_bytes > counters._peak_live_bytes) counters._peak_live_bytes = counters._live_bytes;
+    }
+
+    void record_deallocation(void *pointer) {
+      auto &counters = thread_counters;
+      if (!counters._active || pointer == nullptr) return;
+      counters._deallocations++;
+      counters._live_bytes -= static_cast<int64_t>(malloc_usable_size(pointer));
+    }
+
+    void *allocate(size_t size) {
+      if (size == 0) size = 1;
+      while (true) {
+        void *pointer = std::malloc(size);
+        if (pointer != nullptr) {
+          record_allocation(pointer);
+          return pointer;
+        }
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) return nullptr;
+        handler();
+      }
+    }
+
+    void *allocate_aligned(size_t size, std::align_val_t alignment) {
+      auto align = static_cast<size_t>(alignment);
+      if (align < sizeof(void *)) align = sizeof(void *);
+      // aligned_alloc wants a multiple of the alignment
+      size = (size + align - 1) / align * align;
+      if (size == 0) size = align;
+      while (true) {
+        void *pointer = std::aligned_alloc(align, size);
+        if (pointer != nullptr) {
+          record_allocation(pointer);
+          return pointer;
+        }
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) return nullptr;
+        handler();
+      }
+    }
+
+    void deallocate(void *pointer) {
+      record_deallocation(pointer);
+      std::free(pointer);
+    }
+
+  } // namespace
+
+  bool alloc_stats_compiled_in() { return true; }
+
+#else
+
+  bool alloc_stats_compiled_in() { return false; }
+
+#endif
+
+  void alloc_tracker_t::start() {
+    thread_counters = {};
+    thread_counters._active = true;
+  }
+
+  alloc_stats_t alloc_tracker_t::stop() {
+    auto &counters = thread_counters;
+    counters._active = false;
+    alloc_stats_t stats;
+    stats._allocations = counters._allocations;
+    stats._deallocations = counters._deallocations;
+    stats._bytes = counters._bytes;
+    stats._peak_live_bytes = counters._peak_live_bytes;
+    return stats;
+  }
+
+  scoped_alloc_pause_t::scoped_alloc_pause_t() : _was_active(thread_counters._active) {
+    thread_counters._active = false;
+  }
+
+  scoped_alloc_pause_t::~scoped_alloc_pause_t() {
+    thread_counters._active = _was_active;
+  }
+
+  void print_alloc_report(std::ostream &out, const alloc_stats_t &stats) {
+    if (!alloc_stats_compiled_in()) {
+      out << "  (allocation stats not compiled in)" << std::endl;
+      return;
+    }
+    out << "  allocations " << stats._allocations << "  frees " << stats._deallocations
+        << "  bytes " << stats._bytes << "  peak live bytes " << stats._peak_live_bytes << std::endl;
+  }
+
+} // namespace aoc
+
+#ifdef AOC_ALLOC_STATS
+
+void *operator new(size_t size) {
+  auto pointer = aoc::allocate(size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void *operator new[](size_t size) {
+  auto pointer = aoc::allocate(size);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return aoc::allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return aoc::allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  auto pointer = aoc::allocate_aligned(size, alignment);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+  auto pointer = aoc::allocate_aligned(size, alignment);
+  if (pointer == nullptr) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept { aoc::deallocate(pointer); }
+void operator delete[](void *pointer) noexcept { aoc::deallocate(pointer); }
+void operator delete(void *pointer, size_t) noexcept { aoc::deallocate(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { aoc::deallocate(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { aoc::deallocate(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { aoc::deallocate(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { aoc::deallocate(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { aoc::deallocate(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { aoc::deallocate(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { aoc::deallocate(pointer); }
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+namespace aoc {
+
+  struct alloc_stats_t {
+    uint64_t _allocations = 0;
+    uint64_t _deallocations = 0;
+    uint64_t _bytes = 0;           // Total allocated
+    int64_t _peak_live_bytes = 0;  // Highest (allocated - freed) since start
+  };
+
+  // True when the binary was built with AOC_ALLOC_STATS, which replaces the global operator new/delete with counting
+  // wrappers. Without it the hooks do not exist and nothing is counted.
+  bool alloc_stats_compiled_in();
+
+  // Counts this thread's operator new/delete calls between start() and stop(). Sizes are malloc_usable_size, so
+  // frees of memory allocated before start() are counted too and live bytes may go negative. Memory freed by another
+  // thread is not seen.
+  struct alloc_tracker_t {
+    void start();
+    alloc_stats_t stop();
+  };
+
+  // Stops counting this thread's allocations while alive. Used for harness bookkeeping that runs on the solver's thread,
+  // such as growing the output capture buffer, so chatty solvers are not charged for their output. Pauses nest.
+  struct scoped_alloc_pause_t {
+    bool _was_active;
+
+    scoped_alloc_pause_t();
+    ~scoped_alloc_pause_t();
+
+    scoped_alloc_pause_t(const scoped_alloc_pause_t &) = delete;
+    scoped_alloc_pause_t &operator=(const scoped_alloc_pause_t &) = delete;
+  };
+
+  void print_alloc_report(std::ostream &out, const alloc_stats_t &stats);
+
+} // namespace aoc
@@ -0,0 +1,37 @@
+#include "ascii_port.h"
+
+#include "output_capture.h"
+
+namespace aoc {
+
+  void ascii_port_t::write_line(std::string_view line) {
+    _input.append(line);
+    _input.push_back('\n');
+  }
+
+  std::function<int64_t(void)> ascii_port_t::input_handler() {
+    return [this]() -> int64_t {
+      if (_input_cursor >= _input.size()) return -1;
+      return _input[_input_cursor++];
+    };
+  }
+
+  std::function<void(int64_t)> ascii_port_t::output_handler() {
+    return [this](int64_t value) {
+      _last_output = value;
+      if (value < 0 || value > 127) {
+        _value = value;
+        return;
+      }
+      if (_headless) return;
+      _line.push_back(char(value));
+      if (value == '\n') flush();
+    };
+  }
+
+  void ascii_port_t::flush() {
+    out().write(_line.data(), _line.size());
+    _line.clear();
+  }
+
+} // namespace aoc
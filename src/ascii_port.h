@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace aoc {
+
+  // Buffered I/O for IntCode programs that speak the ASCII protocol. The handlers plug into every day's engine copy
+  // (their handler types are std::function over int64_t). Command scripts are encoded into the input buffer up front,
+  // and text output is collected into a line buffer that is written to aoc::out() one line at a time. In headless mode
+  // text output (e.g. video frames) is discarded. Values outside the ASCII range are never printed; the last one is
+  // kept in _value, and the last output of either kind in _last_output.
+  struct ascii_port_t {
+    std::string _input;
+    size_t _input_cursor = 0;
+    std::string _line;
+    bool _headless = false;
+    int64_t _value = -1;
+    int64_t _last_output = -1;
+
+    void write_line(std::string_view line);
+
+    // Returns -1 once the script is exhausted
+    std::function<int64_t(void)> input_handler();
+    std::function<void(int64_t)> output_handler();
+
+    // Writes out a partial last line
+    void flush();
+  };
+
+} // namespace aoc
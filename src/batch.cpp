@@ -0,0 +1,134 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "input_registry.h"
+#include "intcode_image.h"
+#include "mapped_file.h"
+#include "output_capture.h"
+
+namespace aoc {
+
+  namespace {
+
+    bool ends_with(const std::string &text, const std::string &suffix) {
+      return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    const char *STATUS_NAMES[] = {"ok", "unlabeled", "no_output", "input_unused", "unreadable"};
+
+    // Solvers print "Result : value" (a few "Result: value", a few only the bare value)
+    batch_status_e extract_results(const std::string &output, std::string &outresults) {
+      std::istringstream lines(output);
+      std::string line, last_line, results;
+      while (std::getline(lines, line)) {
+        if (!line.empty()) last_line = line;
+        if (line.rfind("Result", 0) != 0) continue;
+        auto colon_idx = line.find(':');
+        if (colon_idx == std::string::npos) continue;
+        auto value_idx = line.find_first_not_of(' ', colon_idx + 1);
+        if (!results.empty()) results.push_back('|');
+        if (value_idx != std::string::npos) results.append(line, value_idx, std::string::npos);
+      }
+      if (!results.empty()) {
+        outresults = std::move(results);
+        return BATCH_Ok;
+      }
+      outresults = std::move(last_line);
+      return outresults.empty() ? BATCH_NoOutput : BATCH_Unlabeled;
+    }
+
+    std::string csv_field(const std::string &text) {
+      if (text.find_first_of(",\"\n") == std::string::npos) return text;
+      std::string quoted = "\"";
+      for (auto c : text) {
+        if (c == '"') quoted.push_back('"');
+        quoted.push_back(c);
+      }
+      quoted.push_back('"');
+      return quoted;
+    }
+
+  } // namespace
+
+  bool list_batch_inputs(const std::string &dirpath, std::vector<std::string> &outfilepaths) {
+    std::error_code error;
+    std::filesystem::directory_iterator dir_iter(dirpath, error);
+    if (error) return false;
+    for (auto &entry : dir_iter) {
+      if (!entry.is_regular_file(error)) continue;
+      auto filepath = entry.path().string();
+      if (ends_with(filepath, intcode_image::EXTENSION)) continue;
+      outfilepaths.push_back(filepath);
+    }
+    std::sort(outfilepaths.begin(), outfilepaths.end());
+    return true;
+  }
+
+  std::vector<batch_result_t> run_batch(const problem_t &problem, const std::vector<std::string> &input_filepaths, int num_jobs) {
+    std::vector<batch_result_t> results(input_filepaths.size());
+    std::atomic<size_t> next_input_idx{0};
+
+    auto worker = [&]() {
+      while (true) {
+        auto input_idx = next_input_idx++;
+        if (input_idx >= input_filepaths.size()) return;
+        auto &result = results[input_idx];
+        result._input_filepath = input_filepaths[input_idx];
+
+        // Solvers assert on unreadable input, so such an input only gets a row
+        if (!mapped_file_t(result._input_filepath.c_str()).is_valid()) {
+          result._status = BATCH_Unreadable;
+          continue;
+        }
+
+        {
+          scoped_input_override_t input_override(result._input_filepath);
+          scoped_capture_t capture;
+          auto start = std::chrono::steady_clock::now();
+          problem._logic();
+          result._wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+          result._status = extract_results(capture._output, result._results);
+          if (!input_override._consumed) result._status = BATCH_InputUnused;
+        }
+        get_input_registry().release(result._input_filepath);
+      }
+    };
+
+    auto num_threads = std::min<size_t>(std::max(num_jobs, 1), input_filepaths.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; i++) threads.emplace_back(worker);
+    for (auto &thread : threads) thread.join();
+    return results;
+  }
+
+  bool write_batch_csv(const std::string &filepath, const problem_t &problem, const std::vector<batch_result_t> &results) {
+    std::ofstream output_stream(filepath, std::ios::trunc);
+    output_stream << "input,day,problem,status,wall_ms,result\n";
+    for (auto &result : results) {
+      output_stream << csv_field(result._input_filepath) << ',' << problem._day << ',' << problem._problem << ','
+                    << STATUS_NAMES[result._status] << ',' << result._wall_ms << ',' << csv_field(result._results) << '\n';
+    }
+    return output_stream.good();
+  }
+
+  void print_batch_result(std::ostream &out, const batch_result_t &result) {
+    out << result._input_filepath << "  " << result._wall_ms << " ms  ";
+    if (result._status == BATCH_InputUnused) {
+      out << "(input not used by this solver)" << std::endl;
+    } else if (result._status == BATCH_Unreadable) {
+      out << "(could not read input)" << std::endl;
+    } else if (result._status == BATCH_NoOutput) {
+      out << "(no output)" << std::endl;
+    } else {
+      out << "Result : " << result._results << (result._status == BATCH_Unlabeled ? " (unlabeled)" : "") << std::endl;
+    }
+  }
+
+} // namespace aoc
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "scheduler.h"
+
+namespace aoc {
+
+  struct batch_options_t {
+    std::string _inputs_dirpath;
+    std::string _csv_filepath = "batch.csv";
+  };
+
+  enum batch_status_e {
+    BATCH_Ok = 0,     // The solver printed at least one "Result" line
+    BATCH_Unlabeled,  // No "Result" line; the last line of output is taken as the answer
+    BATCH_NoOutput,
+    BATCH_InputUnused, // The solver never read an input file (e.g. day4's built-in range), so the file had no effect
+    BATCH_Unreadable,  // The input could not be read; the solver is not run on it
+  };
+
+  struct batch_result_t {
+    std::string _input_filepath;
+    batch_status_e _status = BATCH_NoOutput;
+    double _wall_ms = 0;
+    std::string _results;    // Every "Result" value the solver printed, separated by '|'
+  };
+
+  // Regular files in dirpath in name order, skipping the IntCode image caches the solvers write next to their inputs
+  bool list_batch_inputs(const std::string &dirpath, std::vector<std::string> &outfilepaths);
+
+  // Runs problem once per input on num_jobs threads, each run reading its input (mapped through the input registry)
+  // in place of the problem's data/ file. The solver's aoc::out() output is captured and only its result lines are kept.
+  // Each input is released from the registry once its run finishes.
+  std::vector<batch_result_t> run_batch(const problem_t &problem, const std::vector<std::string> &input_filepaths, int num_jobs);
+
+  // One "input,day,problem,status,wall_ms,result" row per input
+  bool write_batch_csv(const std::string &filepath, const problem_t &problem, const std::vector<batch_result_t> &results);
+
+  void print_batch_result(std::ostream &out, const batch_result_t &result);
+
+} // namespace aoc
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "micro_bench.h"
+
+#define DECLARE_KERNELS(n) \
+  namespace day##n { \
+    void register_kernels(aoc::kernel_registry_t &registry); \
+  }
+
+// Forward declarations
+DECLARE_KERNELS(8);
+DECLARE_KERNELS(9);
+DECLARE_KERNELS(10);
+DECLARE_KERNELS(12);
+DECLARE_KERNELS(16);
+
+// Micro-benchmarks of isolated solver kernels. Run from the repository root so the puzzle inputs are found.
+// Usage: aoc_bench [name filter] [--samples N] [--min-sample-ms MS]
+int main(int argc, char const *argv[]) {
+  aoc::micro_bench_options_t options;
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+    std::string arg = argv[arg_idx];
+    bool has_value = arg_idx + 1 < argc;
+    try {
+      if (arg == "--samples" && has_value) {
+        options._samples = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--min-sample-ms" && has_value) {
+        options._min_sample_ms = std::stod(argv[++arg_idx]);
+      } else if (arg.rfind("--", 0) != 0) {
+        options._filter = arg;
+      } else {
+        std::cerr << "ERROR: Unknown option " << arg << std::endl;
+        return -1;
+      }
+    } catch (...) {
+      std::cerr << "ERROR: Invalid value for option " << arg << std::endl;
+      return -1;
+    }
+  }
+  if (options._samples < 1 || options._min_sample_ms <= 0) {
+    std::cerr << "ERROR: Need --samples >= 1 and --min-sample-ms > 0" << std::endl;
+    return -1;
+  }
+
+  aoc::kernel_registry_t registry;
+  day8::register_kernels(registry);
+  day9::register_kernels(registry);
+  day10::register_kernels(registry);
+  day12::register_kernels(registry);
+  day16::register_kernels(registry);
+
+  for (auto &kernel : registry) {
+    if (kernel._name.find(options._filter) == std::string::npos) continue;
+    aoc::print_kernel_result(std::cout, aoc::run_kernel(kernel, options));
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <sys/resource.h>
+
+#include "input_registry.h"
+
+namespace aoc {
+
+  namespace {
+
+    double get_cpu_time_ms() {
+      rusage usage{};
+      getrusage(RUSAGE_SELF, &usage);
+      auto to_ms = [](const timeval &tv) { return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0; };
+      return to_ms(usage.ru_utime) + to_ms(usage.ru_stime);
+    }
+
+    void write_stats_json(std::ostream &out, const sample_stats_t &stats) {
+      out << "{\"min\": " << stats._min
+          << ", \"median\": " << stats._median
+          << ", \"p95\": " << stats._p95
+          << ", \"max\": " << stats._max
+          << ", \"mean\": " << stats._mean << "}";
+    }
+
+  } // namespace
+
+  sample_stats_t compute_stats(std::vector<double> samples) {
+    sample_stats_t stats;
+    if (samples.empty()) return stats;
+    std::sort(samples.begin(), samples.end());
+    auto count = samples.size();
+    stats._min = samples.front();
+    stats._max = samples.back();
+    stats._median = (count % 2 == 1) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    // Nearest-rank percentile
+    auto p95_rank = static_cast<size_t>(std::ceil(0.95 * count));
+    stats._p95 = samples[std::max<size_t>(p95_rank, 1) - 1];
+    stats._mean = std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+    return stats;
+  }
+
+  bench_result_t run_benchmark(int day, int problem, const std::function<void(void)> &logic, const bench_options_t &options) {
+    bench_result_t result;
+    result._day = day;
+    result._problem = problem;
+    result._repetitions = options._repetitions;
+    result._cold_inputs = options._cold_inputs;
+
+    std::vector<double> wall_samples, cpu_samples;
+    {
+      silence_cout_t silence_cout;
+      spin_until_stable(options._spin_ms);
+      for (int i = 0; i < options._warmup; i++) logic();
+      for (int i = 0; i < options._repetitions; i++) {
+        if (options._cold_inputs) get_input_registry().clear();
+        auto cpu_start = get_cpu_time_ms();
+        auto wall_start = std::chrono::steady_clock::now();
+        logic();
+        auto wall_end = std::chrono::steady_clock::now();
+        auto cpu_end = get_cpu_time_ms();
+        wall_samples.push_back(std::chrono::duration<double, std::milli>(wall_end - wall_start).count());
+        cpu_samples.push_back(cpu_end - cpu_start);
+      }
+    }
+    result._wall_ms = compute_stats(wall_samples);
+    result._cpu_ms = compute_stats(cpu_samples);
+    return result;
+  }
+
+  void print_bench_result(std::ostream &out, const bench_result_t &result) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3);
+    text << "Day " << result._day << " - Problem " << result._problem << " (" << result._repetitions << " reps, "
+         << (result._cold_inputs ? "cold" : "warm") << " inputs)" << std::endl;
+    text << "  wall ms  min " << result._wall_ms._min << "  median " << result._wall_ms._median
+        << "  p95 " << result._wall_ms._p95 << "  max " << result._wall_ms._max << std::endl;
+    text << "  cpu ms   min " << result._cpu_ms._min << "  median " << result._cpu_ms._median
+        << "  p95 " << result._cpu_ms._p95 << "  max " << result._cpu_ms._max << std::endl;
+    out << text.str() << std::flush;
+  }
+
+  bool write_bench_json(const std::string &filepath, const bench_options_t &options, const cpu_info_t &cpu_info,
+                        const std::vector<bench_result_t> &results) {
+    std::ofstream out(filepath);
+    if (!out) return false;
+    out << std::setprecision(6);
+    out << "{\n  \"warmup\": " << options._warmup << ",\n  \"repetitions\": " << options._repetitions
+        << ",\n  \"inputs\": \"" << (options._cold_inputs ? "cold" : "warm") << "\",\n  \"cpu\": ";
+    write_cpu_info_json(out, cpu_info);
+    out << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+      auto &result = results[i];
+      out << (i > 0 ? ",\n" : "\n");
+      out << "    {\"day\": " << result._day << ", \"problem\": " << result._problem << ", \"wall_ms\": ";
+      write_stats_json(out, result._wall_ms);
+      out << ", \"cpu_ms\": ";
+      write_stats_json(out, result._cpu_ms);
+      out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+  }
+
+  silence_cout_t::silence_cout_t() : _previous(std::cout.rdbuf(&_null_buffer)) {}
+
+  silence_cout_t::~silence_cout_t() {
+    std::cout.rdbuf(_previous);
+  }
+
+} // namespace aoc
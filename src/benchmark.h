@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "cpu_control.h"
+
+namespace aoc {
+
+  struct bench_options_t {
+    int _warmup = 1;
+    int _repetitions = 10;
+    double _spin_ms = 100; // Upper bound of the clock settling spin before each problem's warmup
+    bool _cold_inputs = true; // Clear the input registry before every timed run, so each one maps and parses its input
+    std::string _json_filepath;
+  };
+
+  struct sample_stats_t {
+    double _min = 0;
+    double _median = 0;
+    double _p95 = 0;
+    double _max = 0;
+    double _mean = 0;
+  };
+
+  struct bench_result_t {
+    int _day = 0;
+    int _problem = 0;
+    int _repetitions = 0;
+    bool _cold_inputs = true;
+    sample_stats_t _wall_ms;
+    sample_stats_t _cpu_ms;
+  };
+
+  sample_stats_t compute_stats(std::vector<double> samples);
+
+  // Spins until the clock is stable (see spin_until_stable), runs logic _warmup times untimed, then _repetitions times
+  // measuring wall and CPU (user + system) time. The solver's std::cout output is discarded while benchmarking.
+  // With _cold_inputs (the default) every timed run includes mapping and parsing its input, like a single run of the
+  // problem; otherwise the runs after the warmup are served from the input registry's cache and measure only solving.
+  bench_result_t run_benchmark(int day, int problem, const std::function<void(void)> &logic, const bench_options_t &options);
+
+  void print_bench_result(std::ostream &out, const bench_result_t &result);
+  bool write_bench_json(const std::string &filepath, const bench_options_t &options, const cpu_info_t &cpu_info,
+                        const std::vector<bench_result_t> &results);
+
+  // Discards everything written to it
+  struct null_buffer_t : std::streambuf {
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+  };
+
+  // Redirects std::cout to a null buffer for its lifetime
+  struct silence_cout_t {
+    null_buffer_t _null_buffer;
+    std::streambuf *_previous;
+
+    silence_cout_t();
+    ~silence_cout_t();
+  };
+
+} // namespace aoc
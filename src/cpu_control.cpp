@@ -0,0 +1,197 @@
+#include "cpu_control.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sched.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <thread>
+
+#include "micro_bench.h"
+
+namespace aoc {
+
+  namespace {
+
+    std::string read_first_line(const std::string &filepath) {
+      std::ifstream input_stream(filepath);
+      std::string line;
+      std::getline(input_stream, line);
+      return line;
+    }
+
+    std::string trim(const std::string &text) {
+      auto begin = text.find_first_not_of(" \t");
+      if (begin == std::string::npos) return {};
+      auto end = text.find_last_not_of(" \t");
+      return text.substr(begin, end - begin + 1);
+    }
+
+    // "model name" and "cpu MHz" of the given processor in /proc/cpuinfo
+    void read_proc_cpuinfo(int cpu, std::string &outmodel, double &outmhz) {
+      std::ifstream input_stream("/proc/cpuinfo");
+      std::string line;
+      int processor = -1;
+      while (std::getline(input_stream, line)) {
+        auto colon_idx = line.find(':');
+        if (colon_idx == std::string::npos) continue;
+        auto key = trim(line.substr(0, colon_idx));
+        auto value = trim(line.substr(colon_idx + 1));
+        if (key == "processor") {
+          if (processor == cpu) return;
+          processor = std::stoi(value);
+        } else if (processor == cpu && key == "model name") {
+          outmodel = value;
+        } else if (processor == cpu && key == "cpu MHz") {
+          outmhz = std::stod(value);
+        }
+      }
+    }
+
+    // A chunk of dependent integer work the compiler cannot remove or vectorize
+    uint64_t spin_chunk(uint64_t iterations) {
+      uint64_t state = 0x9e3779b97f4a7c15ull;
+      for (uint64_t i = 0; i < iterations; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        do_not_optimize(state);
+      }
+      return state;
+    }
+
+    std::atomic<size_t> next_worker_cpu_idx{0};
+    std::atomic<bool> worker_pin_failed{false};
+
+  } // namespace
+
+  bool parse_cpu_list(const std::string &text, std::vector<int> &outcpus) {
+    std::vector<int> cpus;
+    std::istringstream input(text);
+    std::string range;
+    while (std::getline(input, range, ',')) {
+      auto dash_idx = range.find('-');
+      try {
+        size_t parsed = 0;
+        int first = std::stoi(range, &parsed);
+        int last = first;
+        if (dash_idx != std::string::npos) {
+          if (parsed != dash_idx) return false;
+          last = std::stoi(range.substr(dash_idx + 1), &parsed);
+          if (dash_idx + 1 + parsed != range.size()) return false;
+        } else if (parsed != range.size()) {
+          return false;
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) return false;
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+      } catch (...) {
+        return false;
+      }
+    }
+    if (cpus.empty()) return false;
+    outcpus = std::move(cpus);
+    return true;
+  }
+
+  bool pin_current_thread(int cpu) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+  }
+
+  void pin_worker_thread(const std::vector<int> &cpus) {
+    thread_local bool pinned = false;
+    if (pinned || cpus.empty()) return;
+    pinned = true;
+    auto cpu = cpus[next_worker_cpu_idx++ % cpus.size()];
+    // Warn once, not once per worker
+    if (!pin_current_thread(cpu) && !worker_pin_failed.exchange(true)) {
+      std::cerr << "WARNING: Could not pin a worker to CPU " << cpu << std::endl;
+    }
+  }
+
+  bool raise_priority() {
+    // Linux nice values are per thread; setting it before any thread is created covers all of them
+    auto original_nice = getpriority(PRIO_PROCESS, 0);
+    for (int nice = -10; nice < original_nice; nice++) {
+      if (setpriority(PRIO_PROCESS, 0, nice) == 0) return true;
+    }
+    return false;
+  }
+
+  double spin_until_stable(double max_ms) {
+    using clock_t = std::chrono::steady_clock;
+    auto start = clock_t::now();
+    auto elapsed_ms = [&]() { return std::chrono::duration<double, std::milli>(clock_t::now() - start).count(); };
+    if (max_ms <= 0) return 0;
+
+    // Calibrate the chunk to roughly a tenth of a millisecond
+    uint64_t iterations = 1024;
+    while (elapsed_ms() < max_ms) {
+      auto chunk_start = clock_t::now();
+      spin_chunk(iterations);
+      if (clock_t::now() - chunk_start >= std::chrono::microseconds(100)) break;
+      iterations *= 2;
+    }
+
+    double previous_ms[2] = {-1, -1};
+    while (elapsed_ms() < max_ms) {
+      auto chunk_start = clock_t::now();
+      spin_chunk(iterations);
+      auto chunk_ms = std::chrono::duration<double, std::milli>(clock_t::now() - chunk_start).count();
+      auto is_close = [&](double other_ms) { return other_ms > 0 && std::abs(chunk_ms - other_ms) <= 0.01 * other_ms; };
+      if (is_close(previous_ms[0]) && is_close(previous_ms[1])) break;
+      previous_ms[1] = previous_ms[0];
+      previous_ms[0] = chunk_ms;
+    }
+    return elapsed_ms();
+  }
+
+  cpu_info_t get_cpu_info(const std::vector<int> &pinned_cpus) {
+    cpu_info_t info;
+    info._pinned_cpus = pinned_cpus;
+    info._num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+    info._nice = getpriority(PRIO_PROCESS, 0);
+    auto cpu = pinned_cpus.empty() ? 0 : pinned_cpus.front();
+    read_proc_cpuinfo(cpu, info._model, info._mhz);
+
+    auto cpufreq_dirpath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/";
+    auto cur_freq_khz = read_first_line(cpufreq_dirpath + "scaling_cur_freq");
+    if (!cur_freq_khz.empty()) info._mhz = std::stod(cur_freq_khz) / 1000;
+    info._governor = read_first_line(cpufreq_dirpath + "scaling_governor");
+    return info;
+  }
+
+  void print_cpu_info(std::ostream &out, const cpu_info_t &info) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(0);
+    text << "CPU: " << (info._model.empty() ? "unknown" : info._model);
+    if (info._mhz > 0) text << " @ " << info._mhz << " MHz";
+    if (!info._governor.empty()) text << " (" << info._governor << ")";
+    text << ", " << info._num_cpus << " CPUs";
+    if (!info._pinned_cpus.empty()) {
+      text << ", pinned to";
+      for (auto cpu : info._pinned_cpus) text << ' ' << cpu;
+    }
+    text << ", nice " << info._nice << std::endl;
+    out << text.str() << std::flush;
+  }
+
+  void write_cpu_info_json(std::ostream &out, const cpu_info_t &info) {
+    out << "{\"model\": \"";
+    for (auto c : info._model) {
+      if (c == '"' || c == '\\') out << '\\';
+      out << c;
+    }
+    out << "\", \"mhz\": " << info._mhz << ", \"governor\": \"" << info._governor << "\", \"num_cpus\": " << info._num_cpus
+        << ", \"pinned_cpus\": [";
+    for (size_t i = 0; i < info._pinned_cpus.size(); i++) out << (i > 0 ? ", " : "") << info._pinned_cpus[i];
+    out << "], \"nice\": " << info._nice << "}";
+  }
+
+} // namespace aoc
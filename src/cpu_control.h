@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace aoc {
+
+  // Run-to-run stability controls for measurements: CPU affinity, scheduling priority and a spin that waits for the
+  // clock to settle before the first sample.
+  struct cpu_options_t {
+    std::vector<int> _pinned_cpus; // Empty: the scheduler places threads freely
+    bool _raise_priority = false;
+  };
+
+  // What the measurements ran on, recorded alongside benchmark results
+  struct cpu_info_t {
+    std::string _model;
+    double _mhz = 0;            // Current frequency of the (first pinned) CPU, 0 if unknown
+    std::string _governor;      // cpufreq governor, empty if the kernel exposes none
+    int _num_cpus = 0;
+    std::vector<int> _pinned_cpus;
+    int _nice = 0;
+  };
+
+  // Parses a list like "2", "0,2,4" or "4-7,12"
+  bool parse_cpu_list(const std::string &text, std::vector<int> &outcpus);
+
+  // Pins the calling thread to cpu. Threads it creates afterwards inherit the affinity.
+  bool pin_current_thread(int cpu);
+
+  // Pins each calling thread, the first time it calls, to the next CPU of cpus in round-robin order. Meant to be called
+  // at the start of every task a thread pool runs. Prints one warning if any worker cannot be pinned.
+  void pin_worker_thread(const std::vector<int> &cpus);
+
+  // Lowers the nice value of the process as far as permitted (down to -10). Returns false if it could not be raised at
+  // all, which is the normal case without CAP_SYS_NICE or an RLIMIT_NICE allowance.
+  bool raise_priority();
+
+  // Busy-loops in fixed chunks of work until three consecutive chunks take the same time within 1% (the core has left
+  // its idle state and finished ramping its clock) or max_ms has passed. Returns the time spent.
+  double spin_until_stable(double max_ms);
+
+  cpu_info_t get_cpu_info(const std::vector<int> &pinned_cpus);
+  void print_cpu_info(std::ostream &out, const cpu_info_t &info);
+  void write_cpu_info_json(std::ostream &out, const cpu_info_t &info);
+
+} // namespace aoc
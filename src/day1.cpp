@@ -1,11 +1,24 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <numeric>
+#include <thread>
+
+#include "output_capture.h"
+#include "text_scanner.h"
+#include "trace_spans.h"
 
 namespace day1 {
 
+  using mass_t = int32_t;
+
+  // Inputs smaller than this are handled by a single thread
+  constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+  // Masses are parsed into a buffer of this size and then handed to a block kernel
+  constexpr size_t BLOCK_SIZE = 4096;
+
   long get_fuel_required(long mass) {
     return (mass / 3) - 2;
   }
@@ -21,16 +34,100 @@ namespace day1 {
     return total_fuel_required;
   }
 
-  long get_total_fuel_required(const std::vector<int> &masses, std::function<long(long)> compute_fn) {
-    return std::accumulate(masses.begin(), masses.end(), 0, [compute_fn](long total, long mass) {
+  template<typename compute_fn_t>
+  int64_t get_total_fuel_required(const std::vector<mass_t> &masses, compute_fn_t compute_fn) {
+    return std::accumulate(masses.begin(), masses.end(), int64_t{0}, [compute_fn](int64_t total, mass_t mass) {
       return total + compute_fn(mass);
     });
   }
 
-  void read_data(std::vector<int> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    std::istream_iterator<int> input_iterator(input_stream);
-    std::copy(input_iterator, std::istream_iterator<int>(), std::back_inserter(outdata));
+  // Block kernels: same results as get_fuel_required / get_fuel_required_recursive summed over the block. The loops
+  // have no data-dependent branches, so the compiler vectorizes them while the totals stay 64-bit: 4 int32 lanes with
+  // the baseline SSE2, 8 or more with -DAOC_NATIVE=ON on an AVX2 (or AVX-512) machine.
+  int64_t get_block_fuel_required(mass_t *masses, size_t count) {
+    int64_t total_fuel_required = 0;
+    for (size_t i = 0; i < count; i++) {
+      total_fuel_required += (masses[i] / 3) - 2;
+    }
+    return total_fuel_required;
+  }
+
+  int64_t get_block_fuel_required_recursive(mass_t *masses, size_t count) {
+    // All lanes iterate until the heaviest one is done; a mass shrinks by 3x per pass, so that is ~20 passes at most
+    int64_t total_fuel_required = 0;
+    mass_t mass_left = 1;
+    while (mass_left != 0) {
+      // OR of the remaining masses rather than a bool, which would keep the loop from vectorizing
+      mass_left = 0;
+      for (size_t i = 0; i < count; i++) {
+        mass_t fuel_required = std::max((masses[i] / 3) - 2, 0);
+        total_fuel_required += fuel_required;
+        masses[i] = fuel_required;
+        mass_left |= fuel_required;
+      }
+    }
+    return total_fuel_required;
+  }
+
+  // Streams the masses in filepath (mapped through the input registry) through block_kernel without materializing
+  // them. Large inputs are split at line boundaries into one chunk per hardware thread, and the per-chunk totals are
+  // summed at the end.
+  template<typename block_kernel_t>
+  int64_t get_total_fuel_required_streaming(const char *filepath, block_kernel_t block_kernel) {
+    AOC_SPAN("parse + fuel");
+    auto input = aoc::get_input_registry().find_or_load(filepath);
+    if (input == nullptr) {
+      std::cerr << "ERROR: Could not read " << filepath << std::endl;
+      assert(0);
+      return 0;
+    }
+    auto text = input->text();
+
+    size_t max_chunks = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t num_chunks = std::clamp<size_t>(text.size() / MIN_CHUNK_BYTES, 1, max_chunks);
+    // Chunk boundaries are moved forward to the start of the next line, so every line belongs to exactly one chunk
+    auto get_chunk_begin = [&](size_t chunk_idx) -> size_t {
+      if (chunk_idx == 0) return 0;
+      if (chunk_idx == num_chunks) return text.size();
+      auto newline_idx = text.find('\n', chunk_idx * text.size() / num_chunks);
+      return newline_idx == std::string_view::npos ? text.size() : newline_idx + 1;
+    };
+
+    std::vector<int64_t> chunk_totals(num_chunks);
+    std::vector<size_t> chunk_num_skipped(num_chunks);
+    auto process_chunk = [&](size_t chunk_idx) {
+      auto begin = get_chunk_begin(chunk_idx);
+      aoc::text_scanner_t scanner(text.substr(begin, get_chunk_begin(chunk_idx + 1) - begin));
+      mass_t masses[BLOCK_SIZE];
+      size_t num_masses = 0;
+      int64_t total_fuel_required = 0;
+      while (!scanner.at_end()) {
+        auto line = scanner.read_line();
+        if (line.empty()) continue;
+        aoc::text_scanner_t line_scanner(line);
+        if (!line_scanner.read_int(masses[num_masses])) {
+          chunk_num_skipped[chunk_idx]++;
+          continue;
+        }
+        if (++num_masses == BLOCK_SIZE) {
+          total_fuel_required += block_kernel(masses, num_masses);
+          num_masses = 0;
+        }
+      }
+      total_fuel_required += block_kernel(masses, num_masses);
+      chunk_totals[chunk_idx] = total_fuel_required;
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t chunk_idx = 1; chunk_idx < num_chunks; chunk_idx++) threads.emplace_back(process_chunk, chunk_idx);
+    process_chunk(0);
+    for (auto &thread : threads) thread.join();
+    auto num_skipped = std::accumulate(chunk_num_skipped.begin(), chunk_num_skipped.end(), size_t{0});
+    if (num_skipped > 0) {
+      std::cerr << "ERROR: Could not parse " << num_skipped << " masses in " << filepath << std::endl;
+      assert(0);
+    }
+    return std::accumulate(chunk_totals.begin(), chunk_totals.end(), int64_t{0});
   }
 
   void problem1() {
@@ -38,20 +135,18 @@ namespace day1 {
     assert(get_fuel_required(14) == 2);
     assert(get_fuel_required(1969) == 654);
     assert(get_fuel_required(100756) == 33583);
+    assert(get_total_fuel_required({12, 14, 1969, 100756}, get_fuel_required) == 34241);
 
-    std::vector<int> input;
-    read_data(input, "data/day1/problem1/input.txt");
-    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required) << std::endl;
+    aoc::out() << "Result : " << get_total_fuel_required_streaming("data/day1/problem1/input.txt", get_block_fuel_required) << std::endl;
   }
 
   void problem2() {
     assert(get_fuel_required_recursive(14) == 2);
     assert(get_fuel_required_recursive(1969) == 966);
     assert(get_fuel_required_recursive(100756) == 50346);
+    assert(get_total_fuel_required({14, 1969, 100756}, get_fuel_required_recursive) == 51314);
 
-    std::vector<int> input;
-    read_data(input, "data/day1/problem2/input.txt");
-    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
+    aoc::out() << "Result : " << get_total_fuel_required_streaming("data/day1/problem2/input.txt", get_block_fuel_required_recursive) << std::endl;
   }
 
 } // namespace day1
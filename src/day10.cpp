@@ -6,6 +6,11 @@
 #include <list>
 #include <cmath>
 
+#include "micro_bench.h"
+#include "output_sink.h"
+#include "text_scanner.h"
+#include "trace_spans.h"
+
 namespace day10 {
 
   using unit_t = int64_t;
@@ -27,6 +32,7 @@ namespace day10 {
     std::vector<std::vector<asteroid_ptr_t>>  _grid;
 
     map_t(const std::vector<std::string> &map) {
+      AOC_SPAN("build map_t");
       unit_t x = 0, y = 0;
       for (auto &row : map) {
         x = 0;
@@ -90,22 +96,23 @@ namespace day10 {
     }
 
     asteroid_location_t find_best_monitoring_station_location(bool trace = false) {
+      AOC_SPAN("solve");
       asteroid_location_t retval;
 
       for (auto &asteroid : _asteroids) {
-        if (trace) std::cout << "Checking asteroid " << asteroid->_x << "," << asteroid->_y << std::endl;
+        if (trace) aoc::out() << "Checking asteroid " << asteroid->_x << "," << asteroid->_y << std::endl;
         visibility_map_t visibility_map;
         compute_visibility(visibility_map, asteroid);
 
         unit_t num_seen = 0;
         for (auto &row : visibility_map) {
           for (auto &cell : row) {
-            if (trace) std::cout << cell;
+            if (trace) aoc::out() << cell;
             if (cell == visibility_e::OCCUPIED) num_seen++;
           }
-          if (trace) std::cout << std::endl;
+          if (trace) aoc::out() << std::endl;
         }
-        if (trace) std::cout << "Seen: " << num_seen << std::endl << std::endl;
+        if (trace) aoc::out() << "Seen: " << num_seen << std::endl << std::endl;
 
         if (num_seen > retval.num_other_asteroids_visible) {
           retval.asteroid = asteroid;
@@ -137,14 +144,15 @@ namespace day10 {
     void print_grid(const asteroid_ptr_t &source = nullptr) {
       for (auto &row : _grid) {
         for (auto &cell : row) {
-          if (cell == source) std::cout << 'S';
-          else std::cout << (cell ? '#' : '.');
+          if (cell == source) aoc::out() << 'S';
+          else aoc::out() << (cell ? '#' : '.');
         }
-        std::cout << std::endl;
+        aoc::out() << std::endl;
       }
     }
 
     asteroid_ptr_t vaporize(const asteroid_ptr_t &source, unit_t iterations, bool trace = false) {
+      AOC_SPAN("vaporize");
       unit_t iterations_completed = 0;
       asteroid_ptr_t last_target = nullptr;
       while (iterations_completed < iterations) {
@@ -156,14 +164,14 @@ namespace day10 {
           _grid[last_target->_y][last_target->_x] = nullptr;
           if (trace) {
             print_grid(source);
-            std::cout << std::endl;
+            aoc::out() << std::endl;
           }
           targets.pop_front();
           iterations_completed++;
         }
 
         if (trace) {
-          std::cout << "Iterations left: " << (iterations - iterations_completed) << std::endl << std::endl;
+          aoc::out() << "Iterations left: " << (iterations - iterations_completed) << std::endl << std::endl;
         }
       }
       return last_target;
@@ -171,10 +179,14 @@ namespace day10 {
   };
 
   void read_data(std::vector<std::string> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    std::copy(std::istream_iterator<std::string>(input_stream),
-              std::istream_iterator<std::string>(),
-              std::back_inserter(outdata));
+    AOC_SPAN("parse");
+    bool loaded = aoc::for_each_line(filepath, [&](std::string_view line) {
+      outdata.emplace_back(line);
+    });
+    if (!loaded) {
+      std::cerr << "ERROR: Could not load asteroid map from " << filepath << std::endl;
+      assert(0);
+    }
   }
 
   void problem1() {
@@ -187,7 +199,7 @@ namespace day10 {
         "...##"
       }};
       auto location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
     }
     {
       map_t map = {{
@@ -203,7 +215,7 @@ namespace day10 {
         ".#....####"
       }};
       auto location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
     }
     {
       map_t map = {{
@@ -219,7 +231,7 @@ namespace day10 {
         ".####.###."
       }};
       auto location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
     }
     {
       map_t map = {{
@@ -235,7 +247,7 @@ namespace day10 {
         ".....#.#.."
       }};
       auto location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
     }
     {
       map_t map = {{
@@ -261,13 +273,13 @@ namespace day10 {
         "###.##.####.##.#..##"
       }};
       auto location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << location.asteroid->_x << "," << location.asteroid->_y << " can see " << location.num_other_asteroids_visible << " other asteroids" << std::endl;
     }
 
     std::vector<std::string> input;
     read_data(input, "data/day10/problem1/input.txt");
     map_t map(input);
-    std::cout << "Result : " << map.find_best_monitoring_station_location().num_other_asteroids_visible << std::endl;
+    aoc::out() << "Result : " << map.find_best_monitoring_station_location().num_other_asteroids_visible << std::endl;
   }
 
   void problem2() {
@@ -280,9 +292,9 @@ namespace day10 {
                        "...##"
                    }};
       auto station_location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << station_location.asteroid->_x << "," << station_location.asteroid->_y << " can see " << station_location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << station_location.asteroid->_x << "," << station_location.asteroid->_y << " can see " << station_location.num_other_asteroids_visible << " other asteroids" << std::endl;
       auto last_vaporized_asteroid = map.vaporize(station_location.asteroid, 7);
-      std::cout << "Last vaporized asteroid is at " << last_vaporized_asteroid->_x << "," << last_vaporized_asteroid->_y << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Last vaporized asteroid is at " << last_vaporized_asteroid->_x << "," << last_vaporized_asteroid->_y << std::endl;
     }
     {
       map_t map = {{
@@ -308,9 +320,9 @@ namespace day10 {
         "###.##.####.##.#..##"
       }};
       auto station_location = map.find_best_monitoring_station_location();
-      std::cout << "Asteroid : " << station_location.asteroid->_x << "," << station_location.asteroid->_y << " can see " << station_location.num_other_asteroids_visible << " other asteroids" << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Asteroid : " << station_location.asteroid->_x << "," << station_location.asteroid->_y << " can see " << station_location.num_other_asteroids_visible << " other asteroids" << std::endl;
       auto last_vaporized_asteroid = map.vaporize(station_location.asteroid, 200);
-      std::cout << "200th vaporized asteroid is at " << last_vaporized_asteroid->_x << "," << last_vaporized_asteroid->_y << std::endl;
+      if (aoc::show_progress()) aoc::out() << "200th vaporized asteroid is at " << last_vaporized_asteroid->_x << "," << last_vaporized_asteroid->_y << std::endl;
     }
 
     std::vector<std::string> input;
@@ -319,7 +331,24 @@ namespace day10 {
     auto station_location = map.find_best_monitoring_station_location();
     auto last_vaporized_asteroid = map.vaporize(station_location.asteroid, 200);
     auto value = last_vaporized_asteroid->_x * 100 + last_vaporized_asteroid->_y;
-    std::cout << "Result : " << value << std::endl;
+    aoc::out() << "Result : " << value << std::endl;
+  }
+
+  void register_kernels(aoc::kernel_registry_t &registry) {
+    std::vector<std::string> input;
+    read_data(input, "data/day10/problem1/input.txt");
+    if (input.empty()) return;
+    auto map = std::make_shared<map_t>(input);
+    // One iteration computes the visibility map of one asteroid, cycling through all of them
+    registry.push_back({"day10 map_t::compute_visibility", [map](uint64_t iterations) {
+      size_t asteroid_idx = 0;
+      for (uint64_t i = 0; i < iterations; i++) {
+        map_t::visibility_map_t visibility_map;
+        map->compute_visibility(visibility_map, map->_asteroids[asteroid_idx]);
+        aoc::do_not_optimize(visibility_map.data());
+        if (++asteroid_idx == map->_asteroids.size()) asteroid_idx = 0;
+      }
+    }});
   }
 
 } // namespace day1
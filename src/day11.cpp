@@ -1,11 +1,15 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
-#include <queue>
+#include <array>
+#include <tuple>
 #include <map>
 
+#include "intcode_image.h"
+#include "output_capture.h"
+#include "trace_spans.h"
+
 namespace day11 {
 
   const bool DEEP_TRACE = false;
@@ -16,6 +20,17 @@ namespace day11 {
   using input_handler_t = std::function<unit_t(void)>;
   using output_handler_t = std::function<void(unit_t)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -29,11 +44,11 @@ namespace day11 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -42,7 +57,7 @@ namespace day11 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -57,8 +72,8 @@ namespace day11 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -117,11 +132,10 @@ namespace day11 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -129,9 +143,9 @@ namespace day11 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -140,18 +154,18 @@ namespace day11 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -159,8 +173,8 @@ namespace day11 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -169,13 +183,13 @@ namespace day11 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -183,13 +197,13 @@ namespace day11 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -198,9 +212,9 @@ namespace day11 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -209,25 +223,25 @@ namespace day11 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -242,28 +256,50 @@ namespace day11 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        bool break_on_output = false,
-        bool trace = false
+        bool break_on_output = false
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted) {
-        auto output_occured = step(input_handler, output_handler, trace);
+        auto output_occured = step(input_handler, output_handler);
         if (output_occured && break_on_output) return;
       }
     }
   };
 
+  // Fixed-arity output frame. Outputs are written straight into the frame buffer; push() returns true once
+  // the frame is complete, and the next push starts a new frame.
+  template<size_t frame_size>
+  struct output_frame_t {
+    std::array<unit_t, frame_size> _values{};
+    size_t _count = 0;
+
+    bool push(unit_t value) {
+      _values[_count++] = value;
+      if (_count < frame_size) return false;
+      _count = 0;
+      return true;
+    }
+  };
+
+  // Output handler that decodes frames of frame_size outputs, e.g. on_frame<3>([](unit_t x, unit_t y, unit_t v) {..})
+  template<size_t frame_size, typename frame_handler_t>
+  output_handler_t on_frame(frame_handler_t frame_handler) {
+    return [frame_handler, frame = output_frame_t<frame_size>{}](unit_t value) mutable {
+      if (frame.push(value)) std::apply(frame_handler, frame._values);
+    };
+  }
+
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -286,7 +322,7 @@ namespace day11 {
   using colored_positions_t = std::map<position_t, unit_t>;
 
   struct painting_robot_t {
-    int_code_program_state_t _program_state;
+    int_code_program_state_t<> _program_state;
 
     static unit_t turn(unit_t current_direction, unit_t turn_direction) {
       switch (current_direction) {
@@ -311,7 +347,6 @@ namespace day11 {
     void run_paint_program(colored_positions_t &painted_positions, unit_t background_color = COLOR_BLACK) {
       unit_t direction = DIR_UP;
       position_t position = {0, 0};
-      std::queue<unit_t> outputs;
 
       _program_state.run([&]() -> unit_t {
         auto painted_position_iter = painted_positions.find(position);
@@ -319,18 +354,13 @@ namespace day11 {
           return painted_position_iter->second;
         }
         return background_color;
-      }, [&](unit_t value) {
-        outputs.push(value);
-        if (outputs.size() == 2) {
-          auto color = outputs.front(); // 0 = black, 1 = white
-          outputs.pop();
-          auto turn_direction = outputs.front();  // 0 = left 90deg, 1 = right 90deg
-          outputs.pop();
-          painted_positions[position] = color;
-          direction = turn(direction, turn_direction);
-          position = move_forward(position, direction);
-        }
-      });
+      }, on_frame<2>([&](unit_t color, unit_t turn_direction) {
+        // color: 0 = black, 1 = white
+        // turn_direction: 0 = left 90deg, 1 = right 90deg
+        painted_positions[position] = color;
+        direction = turn(direction, turn_direction);
+        position = move_forward(position, direction);
+      }));
     }
   };
 
@@ -355,9 +385,9 @@ namespace day11 {
     // Print out grid
     for (auto &row : painted_grid) {
       for (auto &col : row) {
-        std::cout << (col == 1 ? '#': ' ');
+        aoc::out() << (col == 1 ? '#': ' ');
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
   }
 
@@ -366,7 +396,7 @@ namespace day11 {
     read_data(robot._program_state._program_code, "data/day11/problem1/input.txt");
     colored_positions_t painted_positions;
     robot.run_paint_program(painted_positions);
-    std::cout << "Result : " << painted_positions.size() << std::endl;
+    aoc::out() << "Result : " << painted_positions.size() << std::endl;
   }
 
   void problem2() {
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
-#include <regex>
+
+#include "text_scanner.h"
+#include "micro_bench.h"
+#include "output_sink.h"
+#include "trace_spans.h"
 
 namespace day12 {
 
@@ -21,22 +24,23 @@ namespace day12 {
 
     bool operator == (const moon_t &other) const { return _position == other._position && _velocity == other._velocity; }
 
-    friend std::istream &operator>>(std::istream &in, moon_t &moon) {
+    void parse(std::string_view value) {
       // E.g.: <x=9, y=-4, z=14>
-      std::string line;
-      getline(in, line);
-
-      std::regex pattern(R"(<x=(.+), y=(.+), z=(.+)>)");
-      std::smatch matches;
-
-      if (!std::regex_search(line, matches, pattern)) {
+      aoc::text_scanner_t scanner(value);
+      if (
+          !scanner.skip("<x=") || !scanner.read_int(_position._x) ||
+          !scanner.skip(", y=") || !scanner.read_int(_position._y) ||
+          !scanner.skip(", z=") || !scanner.read_int(_position._z) ||
+          !scanner.skip('>')
+          ) {
         throw new std::invalid_argument("Cannot parse step rule!");
       }
+    }
 
-      moon._position._x = std::stoi(matches[1].str());
-      moon._position._y = std::stoi(matches[2].str());
-      moon._position._z = std::stoi(matches[3].str());
-
+    friend std::istream &operator>>(std::istream &in, moon_t &moon) {
+      std::string line;
+      getline(in, line);
+      moon.parse(line);
       return in;
     }
   };
@@ -81,11 +85,15 @@ namespace day12 {
   };
 
   void read_data(std::vector<moon_t> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    moon_t moon;
-    while (!input_stream.eof()) {
-      input_stream >> moon;
+    AOC_SPAN("parse");
+    bool loaded = aoc::for_each_line(filepath, [&](std::string_view line) {
+      moon_t moon;
+      moon.parse(line);
       outdata.push_back(moon);
+    });
+    if (!loaded) {
+      std::cerr << "ERROR: Could not load moons from " << filepath << std::endl;
+      assert(0);
     }
   }
 
@@ -101,7 +109,7 @@ namespace day12 {
       for (unit_t i = 0; i < 10; i++) {
         system.simulate();
       }
-      std::cout << "Test : " << system.get_total_energy() << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Test : " << system.get_total_energy() << std::endl;
     }
 
     system_t system;
@@ -109,7 +117,7 @@ namespace day12 {
     for (unit_t i = 0; i < 1000; i++) {
       system.simulate();
     }
-    std::cout << "Result : " << system.get_total_energy() << std::endl;
+    aoc::out() << "Result : " << system.get_total_energy() << std::endl;
   }
 
   void problem2() {
@@ -128,7 +136,7 @@ namespace day12 {
         for (unit_t moon_idx = 0; moon_idx < moons.size(); moon_idx++) {
           if (system._moons[moon_idx] == moons[moon_idx]) {
             auto delta = step - last_initial_state_step[moon_idx];
-            std::cout << "Found initial state for moon " << moon_idx << " at step " << step << " (delta = " << delta << ")" << std::endl;
+            if (aoc::show_progress()) aoc::out() << "Found initial state for moon " << moon_idx << " at step " << step << " (delta = " << delta << ")" << std::endl;
             last_initial_state_step[moon_idx] = step;
           }
         }
@@ -138,7 +146,20 @@ namespace day12 {
 
 //    std::vector<int> input;
 //    read_data(input, "data/day1/problem2/input.txt");
-//    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
+//    aoc::out() << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
+  }
+
+  void register_kernels(aoc::kernel_registry_t &registry) {
+    auto system = std::make_shared<system_t>();
+    read_data(system->_moons, "data/day12/problem1/input.txt");
+    if (system->_moons.empty()) return;
+    // One iteration is one time step of the puzzle input's moons
+    registry.push_back({"day12 system_t::simulate", [system](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; i++) {
+        system->simulate();
+      }
+      aoc::do_not_optimize(system->_moons.data());
+    }});
   }
 
 } // namespace day1
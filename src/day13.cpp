@@ -1,12 +1,16 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
+#include <array>
+#include <tuple>
 #include <map>
-#include <queue>
 #include <thread>
 
+#include "intcode_image.h"
+#include "output_sink.h"
+#include "trace_spans.h"
+
 namespace day13 {
 
   const bool DEEP_TRACE = false;
@@ -18,6 +22,17 @@ namespace day13 {
   using output_handler_t = std::function<void(unit_t)>;
   using exit_handler_t = std::function<bool(void)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -31,11 +46,11 @@ namespace day13 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -44,7 +59,7 @@ namespace day13 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -59,8 +74,8 @@ namespace day13 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -117,11 +132,10 @@ namespace day13 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -129,9 +143,9 @@ namespace day13 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -140,18 +154,18 @@ namespace day13 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -159,8 +173,8 @@ namespace day13 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -169,13 +183,13 @@ namespace day13 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -183,13 +197,13 @@ namespace day13 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -198,9 +212,9 @@ namespace day13 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -209,25 +223,25 @@ namespace day13 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -242,27 +256,49 @@ namespace day13 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        const exit_handler_t &exit_handler,
-        bool trace = false
+        const exit_handler_t &exit_handler
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted && !exit_handler()) {
-        step(input_handler, output_handler, trace);
+        step(input_handler, output_handler);
       }
     }
   };
 
+  // Fixed-arity output frame. Outputs are written straight into the frame buffer; push() returns true once
+  // the frame is complete, and the next push starts a new frame.
+  template<size_t frame_size>
+  struct output_frame_t {
+    std::array<unit_t, frame_size> _values{};
+    size_t _count = 0;
+
+    bool push(unit_t value) {
+      _values[_count++] = value;
+      if (_count < frame_size) return false;
+      _count = 0;
+      return true;
+    }
+  };
+
+  // Output handler that decodes frames of frame_size outputs, e.g. on_frame<3>([](unit_t x, unit_t y, unit_t v) {..})
+  template<size_t frame_size, typename frame_handler_t>
+  output_handler_t on_frame(frame_handler_t frame_handler) {
+    return [frame_handler, frame = output_frame_t<frame_size>{}](unit_t value) mutable {
+      if (frame.push(value)) std::apply(frame_handler, frame._values);
+    };
+  }
+
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -284,7 +320,7 @@ namespace day13 {
   using tile_map_t = std::map<position_t, unit_t>;
 
   struct arcade_cabinet_t {
-    int_code_program_state_t _program_state;
+    int_code_program_state_t<> _program_state;
     tile_map_t  _tile_map;
     unit_t _score = 0;
     unit_t _joystick_state = JOY_NEUTRAL;
@@ -294,10 +330,11 @@ namespace day13 {
     position_t _paddle_position = {-1, -1};
 
     void render_screen() {
+      AOC_SPAN("render");
       // Uncomment the following lines to see playback with a human friendly refresh rate
 //      std::this_thread::sleep_for(std::chrono::milliseconds(150));
-//      std::cout << "\033[2J" << std::flush;
-      std::cout << std::endl << "SCORE: " << _score << std::endl;
+//      aoc::out() << "\033[2J" << std::flush;
+      aoc::out() << std::endl << "SCORE: " << _score << std::endl;
       // Find dimensions of message
       unit_t min_x = std::numeric_limits<unit_t>::max(), max_x = std::numeric_limits<unit_t>::min();
       unit_t min_y = std::numeric_limits<unit_t>::max(), max_y = std::numeric_limits<unit_t>::min();
@@ -327,17 +364,15 @@ namespace day13 {
             case TILE_BALL: val = '*'; break;
             default: assert(0);
           }
-          std::cout << val;
+          aoc::out() << val;
         }
-        std::cout << std::endl;
+        aoc::out() << std::endl;
       }
     }
 
     void run_program() {
-      std::queue<unit_t> outputs;
-
       _program_state.run([&]() -> unit_t {
-        render_screen();
+        if (aoc::show_progress()) render_screen();
 
         // Autoplay mode!
         auto&& [ball_x, ball_y] = _ball_position;
@@ -349,26 +384,16 @@ namespace day13 {
         }
 
         return _joystick_state;
-      }, [&](unit_t value) {
-        outputs.push(value);
-        if (outputs.size() == 3) {
-          auto x = outputs.front();
-          outputs.pop();
-          auto y = outputs.front();
-          outputs.pop();
-          if (x == -1 && y == 0) {
-            _score = outputs.front();
-            outputs.pop();
-          } else {
-            auto type = outputs.front();
-            outputs.pop();
-            position_t position{x, y};
-            _tile_map[position] = type;
-            if (type == TILE_BALL) _ball_position = position;
-            else if (type == TILE_HORIZ_PADDLE) _paddle_position = position;
-          }
+      }, on_frame<3>([&](unit_t x, unit_t y, unit_t value) {
+        if (x == -1 && y == 0) {
+          _score = value;
+        } else {
+          position_t position{x, y};
+          _tile_map[position] = value;
+          if (value == TILE_BALL) _ball_position = position;
+          else if (value == TILE_HORIZ_PADDLE) _paddle_position = position;
         }
-      }, [&]() -> bool {
+      }), [&]() -> bool {
         return false;
       });
     }
@@ -378,7 +403,7 @@ namespace day13 {
     arcade_cabinet_t arcade_cabinet;
     read_data(arcade_cabinet._program_state._program_code, "data/day13/problem1/input.txt");
     arcade_cabinet.run_program();
-    std::cout << "Result : " << std::count_if(arcade_cabinet._tile_map.begin(), arcade_cabinet._tile_map.end(), [](const auto &v) -> bool { return v.second == TILE_BLOCK; }) << std::endl;
+    aoc::out() << "Result : " << std::count_if(arcade_cabinet._tile_map.begin(), arcade_cabinet._tile_map.end(), [](const auto &v) -> bool { return v.second == TILE_BLOCK; }) << std::endl;
   }
 
   void problem2() {
@@ -386,6 +411,7 @@ namespace day13 {
     read_data(arcade_cabinet._program_state._program_code, "data/day13/problem2/input.txt");
     arcade_cabinet._program_state._program_code[0] = 2; // free play mode
     arcade_cabinet.run_program();
+    aoc::out() << "Result : " << arcade_cabinet._score << std::endl;
   }
 
 } // namespace day1
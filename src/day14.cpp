@@ -1,13 +1,15 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
-#include <regex>
 #include <queue>
 #include <map>
 #include <set>
 
+#include "output_sink.h"
+#include "text_scanner.h"
+#include "trace_spans.h"
+
 namespace day14 {
 
   using unit_t = int64_t;
@@ -17,26 +19,24 @@ namespace day14 {
     std::string _output_chemical{"INVALID"};
     unit_t _output_amount{-1};
 
-    void parse(const std::string &value) {
+    void parse(std::string_view value) {
       // E.g.: 2 AB, 3 BC, 4 CA => 1 FUEL
-      std::regex pattern(R"((.+) => (\d+) ([A-Z]+))");
-      std::smatch matches;
-
-      if (!std::regex_search(value, matches, pattern)) {
+      aoc::text_scanner_t scanner(value);
+      while (true) {
+        unit_t amount = 0;
+        if (!scanner.read_int(amount) || !scanner.skip(' ')) {
+          throw new std::invalid_argument("Cannot parse reaction rule!");
+        }
+        _inputs.emplace_back(scanner.read_word(), amount);
+        if (scanner.skip(", ")) continue;
+        if (scanner.skip(" => ")) break;
         throw new std::invalid_argument("Cannot parse reaction rule!");
       }
 
-      _output_amount = std::stoi(matches[2].str());
-      _output_chemical = matches[3].str();
-
-      auto inputs = matches[1].str();
-      std::regex input_pattern(R"((\d+) ([^,]+))");
-      auto begin = std::sregex_iterator(inputs.begin(), inputs.end(), input_pattern);
-      auto end = std::sregex_iterator();
-      for (auto it = begin; it != end; it++) {
-        matches = *it;
-        _inputs.emplace_back( matches[2].str(), std::stoi(matches[1].str()));
+      if (!scanner.read_int(_output_amount) || !scanner.skip(' ')) {
+        throw new std::invalid_argument("Cannot parse reaction rule!");
       }
+      _output_chemical = scanner.read_word();
     }
 
     friend std::istream &operator>>(std::istream &in, reaction_t &reaction) {
@@ -48,15 +48,20 @@ namespace day14 {
   };
 
   void read_data(std::vector<reaction_t> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    while (!input_stream.eof()) {
+    AOC_SPAN("parse");
+    bool loaded = aoc::for_each_line(filepath, [&](std::string_view line) {
       reaction_t reaction;
-      input_stream >> reaction;
+      reaction.parse(line);
       outdata.push_back(reaction);
+    });
+    if (!loaded) {
+      std::cerr << "ERROR: Could not load reactions from " << filepath << std::endl;
+      assert(0);
     }
   }
 
   unit_t compute_ore_requirement(const std::vector<reaction_t> &reactions, bool trace = false) {
+    AOC_SPAN("solve");
     std::queue<std::pair<std::string, unit_t>> process_queue{};
     std::map<std::string, unit_t> totals;
     std::map<std::string, reaction_t> chemical_reaction_lookup{};
@@ -93,7 +98,7 @@ namespace day14 {
 
     bool done = false;
     while (!done) {
-      if (trace) std::cout << "Begin phase" << std::endl;
+      if (trace) aoc::out() << "Begin phase" << std::endl;
       auto old_totals = totals;
       while (!process_queue.empty()) {
         // Get the next item to process
@@ -101,7 +106,7 @@ namespace day14 {
         process_queue.pop();
         assert(output_chemical != "ORE");
         if (trace) {
-          std::cout << "Processing " << output_amount << " " << output_chemical;
+          aoc::out() << "Processing " << output_amount << " " << output_chemical;
         }
         // Get current total for item
         auto current_total = totals.find(output_chemical) == totals.end() ? 0 : totals[output_chemical];
@@ -109,13 +114,13 @@ namespace day14 {
         auto &reaction = chemical_reaction_lookup[output_chemical];
         auto accum_output = output_amount + current_total;
         if (trace) {
-          std::cout << " (+ " << current_total << ")" << std::endl;
+          aoc::out() << " (+ " << current_total << ")" << std::endl;
         }
         if (accum_output < reaction._output_amount) {
           // We still can't process it. Absorb into totals
           totals[output_chemical] = accum_output;
           if (trace) {
-            std::cout << "\tAbsorbing to totals" << std::endl;
+            aoc::out() << "\tAbsorbing to totals" << std::endl;
           }
         } else {
           // We can process!
@@ -133,7 +138,7 @@ namespace day14 {
             };
             auto&& [new_output_chemical, new_output_amount] = process_rule;
             if (trace) {
-              std::cout << "\tAdded " << new_output_amount << " " << new_output_chemical << std::endl;
+              aoc::out() << "\tAdded " << new_output_amount << " " << new_output_chemical << std::endl;
             }
             if (new_output_chemical == "ORE") {
               totals[new_output_chemical] += new_output_amount;
@@ -151,7 +156,7 @@ namespace day14 {
           auto &reaction = chemical_reaction_lookup[chemical];
           assert(amount < reaction._output_amount);
           if (trace) {
-            std::cout << "%% Adding " << reaction._output_amount << " " << chemical << " (+ " << (reaction._output_amount - amount) << ") for processing" << std::endl;
+            aoc::out() << "%% Adding " << reaction._output_amount << " " << chemical << " (+ " << (reaction._output_amount - amount) << ") for processing" << std::endl;
           }
           // Add extra amounts to enable processing
           process_queue.push({
@@ -183,7 +188,7 @@ namespace day14 {
         reactions.push_back(reaction);
       }
       auto num_ores = compute_ore_requirement(reactions);
-      std::cout << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
+      if (aoc::show_progress()) aoc::out() << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
       assert(num_ores == 31);
     }
     {
@@ -203,7 +208,7 @@ namespace day14 {
         reactions.push_back(reaction);
       }
       auto num_ores = compute_ore_requirement(reactions);
-      std::cout << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
+      if (aoc::show_progress()) aoc::out() << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
       assert(num_ores == 165);
     }
     {
@@ -225,7 +230,7 @@ namespace day14 {
         reactions.push_back(reaction);
       }
       auto num_ores = compute_ore_requirement(reactions);
-      std::cout << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
+      if (aoc::show_progress()) aoc::out() << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
       assert(num_ores == 13312);
     }
     {
@@ -250,7 +255,7 @@ namespace day14 {
         reactions.push_back(reaction);
       }
       auto num_ores = compute_ore_requirement(reactions);
-      std::cout << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
+      if (aoc::show_progress()) aoc::out() << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
       assert(num_ores == 180697);
     }
     {
@@ -280,13 +285,13 @@ namespace day14 {
         reactions.push_back(reaction);
       }
       auto num_ores = compute_ore_requirement(reactions);
-      std::cout << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
+      if (aoc::show_progress()) aoc::out() << "ORE needed for 1 FUEL: " << num_ores << std::endl << std::endl;
       assert(num_ores == 2210736);
     }
 
     std::vector<reaction_t> input;
     read_data(input, "data/day14/problem1/input.txt");
-    std::cout << "Result : " << compute_ore_requirement(input) << std::endl;
+    aoc::out() << "Result : " << compute_ore_requirement(input) << std::endl;
   }
 
   void problem2() {
@@ -294,7 +299,7 @@ namespace day14 {
 
 //    std::vector<int> input;
 //    read_data(input, "data/day1/problem2/input.txt");
-//    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
+//    aoc::out() << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
   }
 
 } // namespace day1
@@ -1,11 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 #include <queue>
 #include <map>
 
+#include "intcode_image.h"
+#include "output_sink.h"
+#include "trace_spans.h"
+
 namespace day15 {
 
   const bool DEEP_TRACE = false;
@@ -17,6 +20,17 @@ namespace day15 {
   using output_handler_t = std::function<void(unit_t)>;
   using exit_handler_t = std::function<bool(void)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -30,11 +44,11 @@ namespace day15 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -43,7 +57,7 @@ namespace day15 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -58,8 +72,8 @@ namespace day15 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -116,11 +130,10 @@ namespace day15 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -128,9 +141,9 @@ namespace day15 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -139,18 +152,18 @@ namespace day15 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -158,8 +171,8 @@ namespace day15 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -168,13 +181,13 @@ namespace day15 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -182,13 +195,13 @@ namespace day15 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -197,9 +210,9 @@ namespace day15 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -208,25 +221,25 @@ namespace day15 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -241,27 +254,26 @@ namespace day15 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        const exit_handler_t &exit_handler,
-        bool trace = false
+        const exit_handler_t &exit_handler
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted && !exit_handler()) {
-        step(input_handler, output_handler, trace);
+        step(input_handler, output_handler);
       }
     }
   };
 
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -289,12 +301,13 @@ namespace day15 {
   using position_t = std::pair<unit_t, unit_t>;
 
   struct remote_control_t {
-    int_code_program_state_t _program_state;
+    int_code_program_state_t<> _program_state;
     std::map<position_t, unit_t> _position_types;
     position_t oxygen_position{-1, -1};
     unit_t run_limit = 3000; //std::numeric_limits<unit_t>::max();
 
     void render_map(const position_t &drone_position) {
+      AOC_SPAN("render");
       unit_t x0 = 0, x1 = 0, y0 = 0, y1 = 0;
       for (auto&& [position, type] : _position_types) {
         auto&& [x, y] = position;
@@ -307,23 +320,23 @@ namespace day15 {
         for (unit_t x = x0; x <= x1; x++) {
           position_t p{x, y};
           if (x == 0 && y == 0 ) {
-            std::cout << 'S';
+            aoc::out() << 'S';
           } else if (drone_position == p) {
-            std::cout << 'D';
+            aoc::out() << 'D';
           } else {
             if (_position_types.find(p) == _position_types.end()) {
-              std::cout << ' ';
+              aoc::out() << ' ';
             } else {
               auto type = _position_types[p];
-              if (type == TYPE_Wall) std::cout << '#';
-              else if (type == TYPE_Moveable) std::cout << '.';
-              else if (type == TYPE_Oxygen) std::cout << 'O';
+              if (type == TYPE_Wall) aoc::out() << '#';
+              else if (type == TYPE_Moveable) aoc::out() << '.';
+              else if (type == TYPE_Oxygen) aoc::out() << 'O';
             }
           }
         }
-        std::cout << std::endl;
+        aoc::out() << std::endl;
       }
-      std::cout << std::endl << std::endl;
+      aoc::out() << std::endl << std::endl;
     }
 
     unit_t get_next_movement_command(const position_t &position) {
@@ -365,20 +378,20 @@ namespace day15 {
 
       // Initial position
       _position_types[current_position] = TYPE_Moveable;
-      if (trace) std::cout << "Can move to " << current_position.first << "," << current_position.second << std::endl;
+      if (trace) aoc::out() << "Can move to " << current_position.first << "," << current_position.second << std::endl;
 
       _program_state.run([&]() -> unit_t {
         if (trace) {
-          std::cout << "MOVES " << ++moves << std::endl;
-          std::cout << "At (" << current_position.first << "," << current_position.second << ") - ";
+          aoc::out() << "MOVES " << ++moves << std::endl;
+          aoc::out() << "At (" << current_position.first << "," << current_position.second << ") - ";
           switch (next_movement_command) {
-            case MOVE_North: std::cout << "Moving NORTH"; break;
-            case MOVE_East: std::cout << "Moving EAST"; break;
-            case MOVE_South: std::cout << "Moving SOUTH"; break;
-            case MOVE_West: std::cout << "Moving WEST"; break;
-            default: std::cout << "UNKNOWN";
+            case MOVE_North: aoc::out() << "Moving NORTH"; break;
+            case MOVE_East: aoc::out() << "Moving EAST"; break;
+            case MOVE_South: aoc::out() << "Moving SOUTH"; break;
+            case MOVE_West: aoc::out() << "Moving WEST"; break;
+            default: aoc::out() << "UNKNOWN";
           }
-          std::cout << std::endl;
+          aoc::out() << std::endl;
         }
         return next_movement_command;
       }, [&](unit_t status) {
@@ -396,7 +409,7 @@ namespace day15 {
         switch (status) {
           case STATUS_HitWall: {
             _position_types[next_position] = TYPE_Wall;
-            if (trace) std::cout << "\tCannot move to " << next_position.first << "," << next_position.second << std::endl;
+            if (trace) aoc::out() << "\tCannot move to " << next_position.first << "," << next_position.second << std::endl;
             break; // Do nothing
           }
           case STATUS_MovedToOxygen:
@@ -409,10 +422,10 @@ namespace day15 {
               _position_types[next_position] = TYPE_Moveable;
             }
             if (!backtracking) {
-              if (trace) std::cout << "\tCan move to " << next_position.first << "," << next_position.second << std::endl;
+              if (trace) aoc::out() << "\tCan move to " << next_position.first << "," << next_position.second << std::endl;
               current_path.push(current_position);
             } else {
-              if (trace) std::cout << "\tBacktracking to " << next_position.first << "," << next_position.second << std::endl;
+              if (trace) aoc::out() << "\tBacktracking to " << next_position.first << "," << next_position.second << std::endl;
             }
             backtracking = false;
             current_position = next_position;
@@ -422,7 +435,7 @@ namespace day15 {
         next_movement_command = get_next_movement_command(current_position);
         if (next_movement_command == MOVE_Invalid) {
           // Backtrack
-          if (trace) std::cout << "\tBacktracking.." << std::endl;
+          if (trace) aoc::out() << "\tBacktracking.." << std::endl;
           done = current_path.empty();
           if (!done) {
             next_movement_command = get_position_movement_command(current_position, current_path.top());
@@ -431,12 +444,12 @@ namespace day15 {
           }
         }
         _last_status = status;
-        render_map(current_position);
+        if (aoc::show_progress()) render_map(current_position);
       }, [&]() -> bool {
         return done || moves >= run_limit;
       });
 
-      if (trace) std::cout << "Found oxygen at " << oxygen_position.first << "," << oxygen_position.second << std::endl;
+      if (trace) aoc::out() << "Found oxygen at " << oxygen_position.first << "," << oxygen_position.second << std::endl;
       return current_path.size();
     }
   };
@@ -471,14 +484,14 @@ namespace day15 {
   void problem1() {
     remote_control_t remote_control;
     read_data(remote_control._program_state._program_code, "data/day15/problem1/input.txt");
-    std::cout << "Result : " << remote_control.run_program() << std::endl;
+    aoc::out() << "Result : " << remote_control.run_program() << std::endl;
   }
 
   void problem2() {
     remote_control_t remote_control;
     read_data(remote_control._program_state._program_code, "data/day15/problem2/input.txt");
     remote_control.run_program(false);
-    std::cout << "Result : " << get_duration_for_oxygen_dissipation(remote_control.oxygen_position, remote_control._position_types) << std::endl;
+    aoc::out() << "Result : " << get_duration_for_oxygen_dissipation(remote_control.oxygen_position, remote_control._position_types) << std::endl;
   }
 
 } // namespace day1
@@ -1,37 +1,43 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 
+#include "digit_stream.h"
+#include "output_sink.h"
+#include "micro_bench.h"
+#include "trace_spans.h"
+
 namespace day16 {
 
   using unit_t = int64_t;
-  using sequence_t = std::vector<unit_t>;
+  using sequence_t = aoc::digit_buffer_t;
+  using pattern_t = std::vector<unit_t>;
 
   void read_data(sequence_t &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    char c;
-    while(input_stream >> c) {
-      outdata.push_back(c - '0');
+    AOC_SPAN("parse");
+    if (!aoc::load_digits(filepath, outdata)) {
+      std::cerr << "ERROR: Could not load signal from " << filepath << std::endl;
+      assert(0);
     }
   }
 
   struct fft_t {
     sequence_t _input;
 
-    static unit_t get_pattern_value(const sequence_t &pattern, unit_t repeat_count, unit_t lookup_idx) {
+    static unit_t get_pattern_value(const pattern_t &pattern, unit_t repeat_count, unit_t lookup_idx) {
       return pattern[(lookup_idx / repeat_count) % pattern.size()];
     }
 
     friend std::ostream& operator << (std::ostream& out, const fft_t& fft) {
       for (auto input_value : fft._input) {
-        out << input_value;
+        out << unit_t(input_value);
       }
       return out;
     }
 
-    void next(const sequence_t &pattern, bool trace = false) {
+    void next(const pattern_t &pattern, bool trace = false) {
+      AOC_SPAN("fft phase");
       sequence_t output;
 
       // For each output
@@ -41,15 +47,15 @@ namespace day16 {
 
         for (auto input_idx = 0; input_idx < _input.size(); input_idx++) {
           unit_t pattern_lookup_idx = input_idx + 1;
-          auto input = _input[input_idx];
+          unit_t input = _input[input_idx];
           auto pattern_value = get_pattern_value(pattern, pattern_repeat_count, pattern_lookup_idx);
-          if (trace && input_idx != 0) std::cout << " + ";
-          if (trace) std::cout << input << '*' << pattern_value;
+          if (trace && input_idx != 0) aoc::out() << " + ";
+          if (trace) aoc::out() << input << '*' << pattern_value;
           accum += (input * pattern_value);
           pattern_lookup_idx++;
         }
         unit_t digit = std::abs(accum) % 10;
-        if (trace) std::cout << " = " << digit << std::endl;
+        if (trace) aoc::out() << " = " << digit << std::endl;
 
         output.push_back(digit); // Store only the last digit
       }
@@ -60,22 +66,23 @@ namespace day16 {
   };
 
   void problem1() {
-    {
+    // The pattern table and the traced example phases are progress output only
+    if (aoc::show_progress()) {
       for (unit_t repeat_count = 1; repeat_count < 9; repeat_count++) {
-        std::cout << repeat_count << " => ";
+        aoc::out() << repeat_count << " => ";
         for (unit_t i = 1; i < 9; i++) {
-          std::cout << std::setw(2) << fft_t::get_pattern_value({0, 1, 0, -1}, repeat_count, i) << " ";
+          aoc::out() << std::setw(2) << fft_t::get_pattern_value({0, 1, 0, -1}, repeat_count, i) << " ";
         }
-        std::cout << std::endl;
+        aoc::out() << std::endl;
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
-    {
+    if (aoc::show_progress()) {
       sequence_t sequence{1,2,3,4,5,6,7,8};
       fft_t fft{sequence};
       for (unit_t i = 0; i < 4; i++) {
         fft.next({0, 1, 0, -1}, true);
-        std::cout << "After " << (i + 1) << " phases: " << fft << std::endl << std::endl;
+        aoc::out() << "After " << (i + 1) << " phases: " << fft << std::endl << std::endl;
       }
     }
 
@@ -84,11 +91,11 @@ namespace day16 {
     for (unit_t i = 0; i < 100; i++) {
       fft.next({0, 1, 0, -1});
     }
-    std::cout << "Result : ";
+    aoc::out() << "Result : ";
     for (unit_t i = 0; i < 8; i++) {
-      std::cout << fft._input[i];
+      aoc::out() << unit_t(fft._input[i]);
     }
-    std::cout << std::endl;
+    aoc::out() << std::endl;
   }
 
   void problem2() {
@@ -102,17 +109,17 @@ namespace day16 {
 //        for (unit_t i = 0; i < copy_idx + 1; i++) {
 //          fft._input.insert(fft._input.end(), input.begin(), input.end());
 //        }
-//        std::cout << "Real input: " << fft._input.size() << " digits" << std::endl;
+//        aoc::out() << "Real input: " << fft._input.size() << " digits" << std::endl;
 //        for (unit_t i = 0; i < 100; i++) {
 //          fft.next({0, 1, 0, -1});
-//          std::cout << "Result : ";
+//          aoc::out() << "Result : ";
 //          for (unit_t offset_idx = 0; offset_idx <= copy_idx; offset_idx++) {
 //            for (unit_t i = 0; i < 8; i++) {
-//              std::cout << fft._input[i + (offset_idx * input.size())];
+//              aoc::out() << fft._input[i + (offset_idx * input.size())];
 //            }
-//            std::cout << " ";
+//            aoc::out() << " ";
 //          }
-//          std::cout << std::endl;
+//          aoc::out() << std::endl;
 //        }
 //      }
     }
@@ -152,17 +159,30 @@ namespace day16 {
     for (unit_t i = 0; i < 1600 + 1; i++) {
       fft._input.insert(fft._input.end(), input.begin(), input.end());
     }
-    std::cout << "Real input: " << fft._input.size() << " digits" << std::endl;
+    if (aoc::show_progress()) aoc::out() << "Real input: " << fft._input.size() << " digits" << std::endl;
 
     for (unit_t i = 0; i < 100; i++) {
-      std::cout << "Step: " << i << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Step: " << i << std::endl;
       fft.next({0, 1, 0, -1});
     }
-    std::cout << "Result : ";
+    aoc::out() << "Result : ";
     for (unit_t i = 0; i < 8; i++) {
-      std::cout << fft._input[(fft._input.size() - 520813) + i];
+      aoc::out() << unit_t(fft._input[(fft._input.size() - 520813) + i]);
     }
-    std::cout << std::endl;
+    aoc::out() << std::endl;
+  }
+
+  void register_kernels(aoc::kernel_registry_t &registry) {
+    auto fft = std::make_shared<fft_t>();
+    if (!aoc::load_digits("data/day16/problem1/input.txt", fft->_input)) return;
+    // One iteration is one phase over the puzzle input (quadratic in its length)
+    registry.push_back({"day16 fft_t::next", [fft](uint64_t iterations) {
+      static const pattern_t pattern = {0, 1, 0, -1};
+      for (uint64_t i = 0; i < iterations; i++) {
+        fft->next(pattern);
+      }
+      aoc::do_not_optimize(fft->_input.data());
+    }});
   }
 
 } // namespace day1
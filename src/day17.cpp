@@ -2,10 +2,14 @@
 #include <vector>
 #include <algorithm>
 #include <string>
-#include <fstream>
 #include <numeric>
 #include <map>
 
+#include "ascii_port.h"
+#include "intcode_image.h"
+#include "output_sink.h"
+#include "trace_spans.h"
+
 namespace day17 {
 
   const bool DEEP_TRACE = false;
@@ -17,6 +21,17 @@ namespace day17 {
   using output_handler_t = std::function<void(unit_t)>;
   using exit_handler_t = std::function<bool(void)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -30,11 +45,11 @@ namespace day17 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -43,7 +58,7 @@ namespace day17 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -58,8 +73,8 @@ namespace day17 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -116,11 +131,10 @@ namespace day17 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -128,9 +142,9 @@ namespace day17 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -139,18 +153,18 @@ namespace day17 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -158,8 +172,8 @@ namespace day17 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -168,13 +182,13 @@ namespace day17 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -182,13 +196,13 @@ namespace day17 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -197,9 +211,9 @@ namespace day17 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -208,25 +222,25 @@ namespace day17 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -241,27 +255,26 @@ namespace day17 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        const exit_handler_t &exit_handler,
-        bool trace = false
+        const exit_handler_t &exit_handler
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted && !exit_handler()) {
-        step(input_handler, output_handler, trace);
+        step(input_handler, output_handler);
       }
     }
   };
 
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -305,10 +318,11 @@ namespace day17 {
   }
 
   struct ascii_program_t {
-    int_code_program_state_t _program_state;
+    int_code_program_state_t<> _program_state;
     std::map<position_t, unit_t> _position_types;
 
     void render_map() {
+      AOC_SPAN("render");
       unit_t x0 = 0, x1 = 0, y0 = 0, y1 = 0;
       for (auto&& [position, type] : _position_types) {
         auto&& [x, y] = position;
@@ -321,20 +335,20 @@ namespace day17 {
         for (unit_t x = x0; x <= x1; x++) {
           position_t p{x, y};
           if (_position_types.find(p) == _position_types.end()) {
-            std::cout << ' ';
+            aoc::out() << ' ';
           } else {
             auto type = _position_types[p];
-            if (type == TYPE_Scaffold) std::cout << '#';
-            else if (type == TYPE_OpenSpace) std::cout << '.';
-            else if (type == TYPE_RobotUp) std::cout << '^';
-            else if (type == TYPE_RobotRight) std::cout << '>';
-            else if (type == TYPE_RobotDown) std::cout << 'v';
-            else if (type == TYPE_RobotLeft) std::cout << '<';
+            if (type == TYPE_Scaffold) aoc::out() << '#';
+            else if (type == TYPE_OpenSpace) aoc::out() << '.';
+            else if (type == TYPE_RobotUp) aoc::out() << '^';
+            else if (type == TYPE_RobotRight) aoc::out() << '>';
+            else if (type == TYPE_RobotDown) aoc::out() << 'v';
+            else if (type == TYPE_RobotLeft) aoc::out() << '<';
           }
         }
-        std::cout << std::endl;
+        aoc::out() << std::endl;
       }
-      std::cout << std::endl << std::endl;
+      aoc::out() << std::endl << std::endl;
     }
 
     void run_scan_program(bool trace = false) {
@@ -344,7 +358,7 @@ namespace day17 {
       _program_state.run([&]() -> unit_t {
         return -1;
       }, [&](unit_t status) {
-        if (trace) std::cout << "Scanned " << current_position.first << ',' << current_position.second << std::endl;
+        if (trace) aoc::out() << "Scanned " << current_position.first << ',' << current_position.second << std::endl;
         switch (status) {
           case TYPE_Scaffold:
           case TYPE_OpenSpace:
@@ -362,7 +376,7 @@ namespace day17 {
             break;
           }
           default: {
-            std::cout << "Unknown status : " << status << std::endl;
+            aoc::out() << "Unknown status : " << status << std::endl;
             assert(0);
           }
         }
@@ -370,7 +384,7 @@ namespace day17 {
         return false;
       });
 
-      render_map();
+      if (aoc::show_progress()) render_map();
     }
 
     std::string add_comma_separators(const std::vector<std::string> &input) {
@@ -388,9 +402,9 @@ namespace day17 {
         const std::vector<std::string> &function_b,
         const std::vector<std::string> &function_c,
         bool continuous_video_feed,
+        bool headless = false,
         bool trace = false
     ) {
-      unit_t output = 0;
       std::vector<std::string> inputs = {
           add_comma_separators(main_movement_routine),
           add_comma_separators(function_a),
@@ -398,50 +412,21 @@ namespace day17 {
           add_comma_separators(function_c),
           continuous_video_feed ? "y" : "n"
       };
-      unit_t input_mode = 0;
-      unit_t input_cursor_idx = 0;
+      aoc::ascii_port_t ascii_port;
+      ascii_port._headless = headless;
+      for (unit_t i = 0; i < inputs.size(); i++) {
+        if (trace) aoc::out() << i << "] Input : " << inputs[i] << std::endl;
+        ascii_port.write_line(inputs[i]);
+      }
 
       _program_state._program_code[0] = 2; // Wake up
 
-      _program_state.run([&]() -> unit_t {
-        char output = -1;
-        if (input_mode < inputs.size()) {
-          if (input_cursor_idx < inputs[input_mode].size()) {
-            output = inputs[input_mode][input_cursor_idx];
-            input_cursor_idx++;
-          } else {
-            input_mode++;
-            input_cursor_idx = 0;
-            output = 10;
-          }
-        }
-        if (trace) std::cout << input_mode << "] Input : " << output << "(" << char(output) << ")" << std::endl;
-        return output;
-      }, [&](unit_t status) {
-        switch (status) {
-          case TYPE_Scaffold:
-          case TYPE_OpenSpace:
-          case TYPE_RobotUp:
-          case TYPE_RobotDown:
-          case TYPE_RobotLeft:
-          case TYPE_RobotRight:
-          case 10: {
-            std::cout << char(status);
-            break;
-          }
-          default: {
-            if (status > 1000) {
-              output = status;
-            } else {
-              std::cout << char(status);
-            }
-          }
-        }
-      }, [&]() -> bool {
+      _program_state.run(ascii_port.input_handler(), ascii_port.output_handler(), [&]() -> bool {
         return false;
       });
-      std::cout << std::endl;
-      return output;
+      ascii_port.flush();
+      if (!ascii_port._headless) aoc::out() << std::endl;
+      return ascii_port._value;
     }
   };
 
@@ -451,14 +436,14 @@ namespace day17 {
     ascii_program_t ascii_program;
     ascii_program._program_state.reset(code);
 
-    ascii_program.run_scan_program(true);
+    ascii_program.run_scan_program(aoc::show_progress());
     auto intersections = get_intersections(ascii_program._position_types);
     unit_t result = 0;
     for (auto &intersection : intersections) {
-      std::cout << "Found intersection at (" << intersection.first << "," << intersection.second << ") = " << (intersection.first * intersection.second) << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Found intersection at (" << intersection.first << "," << intersection.second << ") = " << (intersection.first * intersection.second) << std::endl;
       result += (intersection.first * intersection.second);
     }
-    std::cout << "Result : " << result << std::endl;
+    aoc::out() << "Result : " << result << std::endl;
   }
 
   // https://stackoverflow.com/questions/2896600/how-to-replace-all-occurrences-of-a-character-in-string
@@ -500,25 +485,25 @@ namespace day17 {
 //        std::string temp = search;
 //        std::string f0str = search.substr(0, f0);
 //        replaceAll(temp, f0str, "_");
-//        std::cout << temp << std::endl;
+//        aoc::out() << temp << std::endl;
 //        for (unit_t f1 = 1; f1 < 11; f1++) {
 //          auto temp2 = temp;
 //          std::string f1str = search.substr(f0, f1);
 //          replaceAll(temp2, f1str, "_");
-//          std::cout << "\t" << temp2 << std::endl;
+//          aoc::out() << "\t" << temp2 << std::endl;
 //          for (unit_t f2 = 1; f2 < 11; f2++) {
 //            auto temp3 = temp2;
 //            std::string f2str = search.substr(f1, f2);
 //            replaceAll(temp3, f2str, "_");
-//            std::cout << "\t\t" << temp3 << std::endl;
+//            aoc::out() << "\t\t" << temp3 << std::endl;
 //            replaceAll(temp3, "_", "");
 //            if (temp3.empty()) {
-//              std::cout << "############## FOUND IT" << std::endl;
+//              aoc::out() << "############## FOUND IT" << std::endl;
 //              exit(0);
 //            }
 //          }
 //        }
-//        std::cout << std::endl;
+//        aoc::out() << std::endl;
 //      }
 //    }
 //    exit(0);
@@ -568,38 +553,38 @@ namespace day17 {
                                      });
       }
       else {
-        std::cout << "Unknown instruction! " << instruction << std::endl;
+        aoc::out() << "Unknown instruction! " << instruction << std::endl;
         exit(0);
       }
     }
     // For every combination of all possible values, check if there are 3 patterns that cover the generated instruction
     std::function<void(unit_t, const std::string&)> process_combination = [&](unit_t instruction_idx, const std::string &accum) {
       if (instruction_idx >= instruction_values.size()) {
-        std::cout << "Testing " << accum << std::endl;
+        aoc::out() << "Testing " << accum << std::endl;
         for (unit_t f0 = 1; f0 < 11; f0++) {
           std::string temp = accum;
           std::string f0str = accum.substr(0, f0);
           replaceAll(temp, f0str, "_");
-//        std::cout << temp << std::endl;
+//        aoc::out() << temp << std::endl;
           for (unit_t f1 = 1; f1 < 11; f1++) {
             auto temp2 = temp;
             std::string f1str = accum.substr(f0, f1);
             replaceAll(temp2, f1str, "_");
-//          std::cout << temp2 << std::endl;
+//          aoc::out() << temp2 << std::endl;
             for (unit_t f2 = 1; f2 < 11; f2++) {
               auto temp3 = temp2;
               std::string f2str = accum.substr(f1, f2);
               replaceAll(temp3, f2str, "_");
-//              std::cout << temp3 << std::endl;
+//              aoc::out() << temp3 << std::endl;
               replaceAll(temp3, "_", "");
               if (temp3.size() == 0) {
-                std::cout << "############## FOUND IT" << std::endl;
+                aoc::out() << "############## FOUND IT" << std::endl;
                 exit(0);
               }
             }
           }
         }
-//        std::cout << std::endl;
+//        aoc::out() << std::endl;
         return;
       }
       for (unit_t i = 0; i < instruction_values[instruction_idx].size(); i++) {
@@ -627,12 +612,13 @@ namespace day17 {
         function_b,
         function_c,
         true,
-        true
+        !aoc::show_progress(),
+        aoc::show_progress()
     );
     if (result != 'X') {
-      std::cout << "Result : " << result << std::endl;
+      aoc::out() << "Result : " << result << std::endl;
     } else {
-      std::cout << "Went off into space!" << std::endl;
+      aoc::out() << "Went off into space!" << std::endl;
     }
 }
 
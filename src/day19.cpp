@@ -1,10 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 #include <set>
 
+#include "intcode_image.h"
+#include "output_sink.h"
+#include "shard.h"
+#include "trace_spans.h"
+
 namespace day19 {
 
   const bool DEEP_TRACE = false;
@@ -16,6 +20,17 @@ namespace day19 {
   using output_handler_t = std::function<void(unit_t)>;
   using exit_handler_t = std::function<bool(void)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -29,11 +44,11 @@ namespace day19 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -42,7 +57,7 @@ namespace day19 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -57,8 +72,8 @@ namespace day19 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -115,11 +130,10 @@ namespace day19 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -127,9 +141,9 @@ namespace day19 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -138,18 +152,18 @@ namespace day19 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -157,8 +171,8 @@ namespace day19 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -167,13 +181,13 @@ namespace day19 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -181,13 +195,13 @@ namespace day19 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -196,9 +210,9 @@ namespace day19 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -207,25 +221,25 @@ namespace day19 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -240,27 +254,26 @@ namespace day19 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        const exit_handler_t &exit_handler,
-        bool trace = false
+        const exit_handler_t &exit_handler
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted && !exit_handler()) {
-        step(input_handler, output_handler, trace);
+        step(input_handler, output_handler);
       }
     }
   };
 
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -269,7 +282,7 @@ namespace day19 {
   struct drone_t {
 
     unit_t check_point(int_code_program_t &code, unit_t x, unit_t y) {
-      int_code_program_state_t _program_state;
+      int_code_program_state_t<> _program_state;
       unit_t output = 0;
       std::vector<unit_t> input;
       unit_t input_cursor_idx = 0;
@@ -291,16 +304,20 @@ namespace day19 {
       return output;
     }
 
-    unit_t find_num_points_affected(int_code_program_t &code, unit_t width, unit_t height, bool trace = false) {
+    unit_t find_num_points_affected(int_code_program_t &code, unit_t width, unit_t height, bool trace = false, const aoc::shard_t &shard = {}) {
       unit_t affected_points = 0;
 
       for (unit_t y = 0; y < height; y++) {
         for (unit_t x = 0; x < width; x++) {
+          if (!shard.owns(y * width + x)) {
+            if (trace) aoc::out() << ' ';
+            continue;
+          }
           auto status = check_point(code, x, y);
-          if (trace) std::cout << (status ? '#' : '.');
+          if (trace) aoc::out() << (status ? '#' : '.');
           affected_points += status;
         }
-        if (trace) std::cout << std::endl;
+        if (trace) aoc::out() << std::endl;
       }
 
       return affected_points;
@@ -311,48 +328,48 @@ namespace day19 {
       std::set<point_t> affected_points_lookup;
       unit_t check_width = 3000, check_height = 3000;
 
-      std::cout << "Gather data.." << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Gather data.." << std::endl;
       for (unit_t y = 0; y < check_height; y++) {
         for (unit_t x = 0; x < check_width; x++) {
           auto status = check_point(code, x, y);
-          if (trace) std::cout << (status ? '#' : '.');
+          if (trace) aoc::out() << (status ? '#' : '.');
           if (status) {
             ordered_affected_points.emplace_back(x, y);
             affected_points_lookup.insert({x, y});
           }
         }
-        if (trace) std::cout << std::endl;
+        if (trace) aoc::out() << std::endl;
       }
 
-      std::cout << "Checking data.." << std::endl;
+      if (aoc::show_progress()) aoc::out() << "Checking data.." << std::endl;
       // For every affected point (points are ordered properly)
       for (auto&& [affected_x, affected_y] : ordered_affected_points) {
-        if (trace) std::cout << "Checking " << affected_x << "," << affected_y << std::endl;
+        if (trace) aoc::out() << "Checking " << affected_x << "," << affected_y << std::endl;
         bool ok = true;
         // Perform scan of perimeter
         for (unit_t x = 0; x < ship_width && ok; x++) {
           point_t pt = {affected_x + x, affected_y};
-          if (trace) std::cout << "\t" << pt.first << "," << pt.second;
+          if (trace) aoc::out() << "\t" << pt.first << "," << pt.second;
           ok = ok && (affected_points_lookup.find(pt) != affected_points_lookup.end());
-          if (trace) std::cout << " " << ok << std::endl;
+          if (trace) aoc::out() << " " << ok << std::endl;
         }
         for (unit_t x = 0; x < ship_width && ok; x++) {
           point_t pt = {affected_x + x, affected_y + ship_height - 1};
-          if (trace) std::cout << "\t" << pt.first << "," << pt.second;
+          if (trace) aoc::out() << "\t" << pt.first << "," << pt.second;
           ok = ok && (affected_points_lookup.find(pt) != affected_points_lookup.end());
-          if (trace) std::cout << " " << ok << std::endl;
+          if (trace) aoc::out() << " " << ok << std::endl;
         }
         for (unit_t y = 0; y < ship_height && ok; y++) {
           point_t pt = {affected_x, affected_y + y};
-          if (trace) std::cout << "\t" << pt.first << "," << pt.second;
+          if (trace) aoc::out() << "\t" << pt.first << "," << pt.second;
           ok = ok && (affected_points_lookup.find(pt) != affected_points_lookup.end());
-          if (trace) std::cout << " " << ok << std::endl;
+          if (trace) aoc::out() << " " << ok << std::endl;
         }
         for (unit_t y = 0; y < ship_height && ok; y++) {
           point_t pt = {affected_x + ship_width - 1, affected_y + y};
-          if (trace) std::cout << "\t" << pt.first << "," << pt.second;
+          if (trace) aoc::out() << "\t" << pt.first << "," << pt.second;
           ok = ok && (affected_points_lookup.find(pt) != affected_points_lookup.end());
-          if (trace) std::cout << " " << ok << std::endl;
+          if (trace) aoc::out() << " " << ok << std::endl;
         }
         if (ok) {
           return {affected_x, affected_y};
@@ -367,8 +384,8 @@ namespace day19 {
     int_code_program_t code;
     read_data(code, "data/day19/problem1/input.txt");
     drone_t drone;
-    unit_t num_points_affected = drone.find_num_points_affected(code, 50, 50, true);
-    std::cout << "Result : " << num_points_affected << std::endl;
+    unit_t num_points_affected = drone.find_num_points_affected(code, 50, 50, aoc::show_progress(), aoc::get_shard());
+    aoc::report_result(19, 1, aoc::REDUCE_Sum, num_points_affected);
   }
 
   void problem2() {
@@ -376,7 +393,7 @@ namespace day19 {
     read_data(code, "data/day19/problem2/input.txt");
     drone_t drone;
     point_t pt = drone.find_point_where_ship_fits(code, 100, 100, false);
-    std::cout << "Result : " << (pt.first * 10000 + pt.second) << std::endl;
+    aoc::out() << "Result : " << (pt.first * 10000 + pt.second) << std::endl;
   }
 
 } // namespace day1
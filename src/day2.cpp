@@ -1,14 +1,29 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <set>
 #include <numeric>
 
+#include "intcode_image.h"
+#include "output_capture.h"
+#include "shard.h"
+#include "trace_spans.h"
+
 namespace day2 {
 
   using int_code_program_t = std::vector<long>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t  program_code;
     int                 instruction_pointer = 0;
@@ -30,14 +45,14 @@ namespace day2 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
-    void step(bool trace) {
+    void step() {
       auto opcode = program_code[instruction_pointer];
       switch (opcode) {
         case 1: {
@@ -50,7 +65,7 @@ namespace day2 {
           auto write_idx = program_code[instruction_pointer + 3];
           program_code[write_idx] = result;
           instruction_pointer += 4;
-          if (trace) print_program_code();
+          if constexpr (trace_policy_t::enabled) print_program_code();
           break;
         }
         case 2: {
@@ -63,13 +78,13 @@ namespace day2 {
           auto write_idx = program_code[instruction_pointer + 3];
           program_code[write_idx] = result;
           instruction_pointer += 4;
-          if (trace) print_program_code();
+          if constexpr (trace_policy_t::enabled) print_program_code();
           break;
         }
         case 99: {
           // HALT
           halted = true;
-          if (trace) print_program_code();
+          if constexpr (trace_policy_t::enabled) print_program_code();
           return;
         }
         default: {
@@ -78,82 +93,91 @@ namespace day2 {
       }
     }
 
-    void run(bool trace = false) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+    void run() {
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!halted) {
-        step(trace);
+        step();
       }
     }
 
   };
 
   void read_data(std::vector<long> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
     }
   }
 
   void problem1() {
     {
-      int_code_program_state_t test{{{1,9,10,3,2,3,11,0,99,30,40,50}}};
+      int_code_program_state_t<> test{{{1,9,10,3,2,3,11,0,99,30,40,50}}};
       test.run();
       assert(test.program_code[0] == 3500);
     }
 
     {
-      int_code_program_state_t test{{{1,0,0,0,99}}};
+      int_code_program_state_t<> test{{{1,0,0,0,99}}};
       test.run();
       assert(test.program_code[0] == 2);
     }
 
     {
-      int_code_program_state_t test{{{2,3,0,3,99}}};
+      int_code_program_state_t<> test{{{2,3,0,3,99}}};
       test.run();
       assert(test.program_code[3] == 6);
     }
 
     {
-      int_code_program_state_t test{{{2,4,4,5,99,0}}};
+      int_code_program_state_t<> test{{{2,4,4,5,99,0}}};
       test.run();
       assert(test.program_code[5] == 9801);
     }
 
     {
-      int_code_program_state_t test{{{1,1,1,4,99,5,6,0,99}}};
+      int_code_program_state_t<> test{{{1,1,1,4,99,5,6,0,99}}};
       test.run();
       assert(test.program_code[0] == 30);
     }
 
-    int_code_program_state_t program_state;
+    int_code_program_state_t<> program_state;
     read_data(program_state.program_code, "data/day2/problem1/input.txt");
     program_state.set_1202_program_alarm();
     program_state.run();
-    std::cout << "Result : " << program_state.program_code[0] << std::endl;
+    aoc::out() << "Result : " << program_state.program_code[0] << std::endl;
   }
 
   void problem2() {
     int_code_program_t program_code;
     read_data(program_code, "data/day2/problem2/input.txt");
-    int_code_program_state_t program_state;
+    int_code_program_state_t<> program_state;
+    auto &shard = aoc::get_shard();
     for (int noun = 0; noun <= 99; noun++) {
       for (int verb = 0; verb <= 99; verb++) {
+        // The first match in sweep order is the smallest 100 * noun + verb, so shards combine with min
+        if (!shard.owns(100 * noun + verb)) continue;
         program_state.reset(program_code);
         program_state.initialize(noun, verb);
         program_state.run();
         if (program_state.program_code[0] == 19690720) {
-          std::cout << "Result: " << (100 * noun + verb) << std::endl;
+          if (shard.is_sharded()) {
+            aoc::report_result(2, 2, aoc::REDUCE_Min, 100 * noun + verb);
+          } else {
+            aoc::out() << "Result: " << (100 * noun + verb) << std::endl;
+          }
           return;
         }
       }
     }
-    std::cout << "ERROR: Could not find value at address 0!" << std::endl;
+    if (shard.is_sharded()) {
+      aoc::report_no_candidate(2, 2, aoc::REDUCE_Min);
+      return;
+    }
+    aoc::out() << "ERROR: Could not find value at address 0!" << std::endl;
   }
 
 } // namespace day2
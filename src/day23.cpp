@@ -1,10 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
+#include <array>
 #include <queue>
 
+#include "intcode_image.h"
+#include "output_capture.h"
+#include "trace_spans.h"
+
 namespace day23 {
 
   const bool DEEP_TRACE = false;
@@ -16,24 +20,66 @@ namespace day23 {
   using output_handler_t = std::function<void(unit_t)>;
   using exit_handler_t = std::function<bool(void)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
     unit_t _relative_base_pointer = 0;
     bool _halted = false;
 
+    // Spin detection. _memory_hash is updated incrementally on every write, so two snapshots compare equal
+    // when the memory contents match. A program that re-enters its last INPUT instruction with the same
+    // registers and memory, without producing output, will replay the same loop for as long as it is fed
+    // the same input value.
+    struct input_snapshot_t {
+      unit_t _instruction_pointer = -1;
+      unit_t _relative_base_pointer = 0;
+      uint64_t _memory_hash = 0;
+      unit_t _input = 0;
+    };
+    uint64_t _memory_hash = 0;
+    input_snapshot_t _last_input;
+    bool _output_since_input = false;
+    bool _spinning = false;
+
     void reset(const int_code_program_t &program_code) {
       _program_code = program_code;
       _instruction_pointer = 0;
       _halted = false;
+      _memory_hash = 0;
+      _last_input = {};
+      _output_since_input = false;
+      _spinning = false;
+    }
+
+    // True if the program is polling and feeding it next_input would only replay the loop
+    bool is_spinning_on(unit_t next_input) const {
+      return _spinning && next_input == _last_input._input;
+    }
+
+    static uint64_t cell_hash(unit_t address, unit_t value) {
+      uint64_t hash = static_cast<uint64_t>(address) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(value);
+      hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+      hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+      return hash ^ (hash >> 31);
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -42,7 +88,7 @@ namespace day23 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -57,8 +103,8 @@ namespace day23 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -107,6 +153,7 @@ namespace day23 {
       }
       // Handle out of bounds
       if (address >= _program_code.size()) _program_code.resize(address + 1, 0);
+      _memory_hash ^= cell_hash(address, _program_code[address]) ^ cell_hash(address, value);
       _program_code[address] = value;
 
       return address;
@@ -115,11 +162,10 @@ namespace day23 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -127,9 +173,9 @@ namespace day23 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -138,27 +184,35 @@ namespace day23 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
+          bool same_state = !_output_since_input &&
+                            _last_input._instruction_pointer == _instruction_pointer &&
+                            _last_input._relative_base_pointer == _relative_base_pointer &&
+                            _last_input._memory_hash == _memory_hash;
           auto input = input_handler();
+          _spinning = same_state && input == _last_input._input;
+          _last_input = {_instruction_pointer, _relative_base_pointer, _memory_hash, input};
+          _output_since_input = false;
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
           // OUTPUT
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
+          _output_since_input = true;
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -167,13 +221,13 @@ namespace day23 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -181,13 +235,13 @@ namespace day23 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -196,9 +250,9 @@ namespace day23 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -207,25 +261,25 @@ namespace day23 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -240,28 +294,42 @@ namespace day23 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        const exit_handler_t &exit_handler,
-        bool trace = false
+        const exit_handler_t &exit_handler
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
-      step(input_handler, output_handler, trace);
+      step(input_handler, output_handler);
       while (!_halted && !exit_handler()) {
-        step(input_handler, output_handler, trace);
+        step(input_handler, output_handler);
       }
     }
   };
 
+  // Fixed-arity output frame. Outputs are written straight into the frame buffer; push() returns true once
+  // the frame is complete, and the next push starts a new frame.
+  template<size_t frame_size>
+  struct output_frame_t {
+    std::array<unit_t, frame_size> _values{};
+    size_t _count = 0;
+
+    bool push(unit_t value) {
+      _values[_count++] = value;
+      if (_count < frame_size) return false;
+      _count = 0;
+      return true;
+    }
+  };
+
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
@@ -274,35 +342,33 @@ namespace day23 {
   };
 
   struct computer_t {
-    int_code_program_state_t _program_state;
+    int_code_program_state_t<> _program_state;
     unit_t _address;
     std::queue<unit_t> _receive_queue;
-    std::queue<unit_t> _send_queue;
+    output_frame_t<3> _send_frame;
 
     request_t step(bool trace = false) {
-//      std::cout << "Stepping computer " << _address << " (" << _program_state._instruction_pointer << ")" << std::endl;
+//      aoc::out() << "Stepping computer " << _address << " (" << _program_state._instruction_pointer << ")" << std::endl;
       request_t output;
+      // Fast-forward: a NIC polling an empty queue would only spin until a packet arrives
+      if (_receive_queue.empty() && _program_state.is_spinning_on(-1)) return output;
       _program_state.run([&]() -> unit_t {
-        if (trace) std::cout << _address << " read" << std::endl;
+        if (trace) aoc::out() << _address << " read" << std::endl;
         unit_t data = -1;
         if (!_receive_queue.empty()) {
           data = _receive_queue.front();
           _receive_queue.pop();
-          if (trace) std::cout << _address << " <- " << data << std::endl;
+          if (trace) aoc::out() << _address << " <- " << data << std::endl;
         }
         return data;
       }, [&](unit_t data) {
-        if (trace) std::cout << _address << " write" << std::endl;
-        _send_queue.push(data);
-        if (_send_queue.size() == 3) {
+        if (trace) aoc::out() << _address << " write" << std::endl;
+        if (_send_frame.push(data)) {
           // Flush
-          output._destination = _send_queue.front();
-          _send_queue.pop();
-          output._data.first = _send_queue.front();
-          _send_queue.pop();
-          output._data.second = _send_queue.front();
-          _send_queue.pop();
-          if (trace) std::cout << _address << "\t -> \t" << output._destination << " (" << output._data.first << "," << output._data.second << ")" << std::endl;
+          auto &[destination, x, y] = _send_frame._values;
+          output._destination = destination;
+          output._data = {x, y};
+          if (trace) aoc::out() << _address << "\t -> \t" << output._destination << " (" << output._data.first << "," << output._data.second << ")" << std::endl;
         }
       }, [&]() -> bool {
         return true;
@@ -357,7 +423,7 @@ namespace day23 {
     while (network._nat_packets.empty()) {
       network.step();
     }
-    std::cout << "Result: " << network._nat_packets.front().second << std::endl;
+    aoc::out() << "Result: " << network._nat_packets.front().second << std::endl;
   }
 
   void problem2() {
@@ -382,7 +448,7 @@ namespace day23 {
         }
       }
     }
-    std::cout << "Result: " << last_nat_flush_packet.second << std::endl;
+    aoc::out() << "Result: " << last_nat_flush_packet.second << std::endl;
   }
 
 } // namespace day1
@@ -1,13 +1,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <set>
 #include <numeric>
-#include <sstream>
-#include <regex>
 #include <math.h>
 
+#include "output_capture.h"
+#include "text_scanner.h"
+#include "trace_spans.h"
+
 namespace day3 {
 
   using point_t = std::pair<int, int>;
@@ -25,35 +26,31 @@ namespace day3 {
   struct wire_t {
     std::vector<line_seg_t> segments;
 
-    void initialize(const std::string& path) {
+    void initialize(std::string_view path) {
       // E.g.: R8,U5,L5,D3
-      std::regex pattern("(U|D|L|R)(\\d+)");
-      std::smatch matches;
+      aoc::text_scanner_t scanner(path);
 
       point_t curr_point = {0, 0};
 
-      std::stringstream input_stream(path);
-      while( input_stream.good() )
-      {
-        std::string substr;
-        getline( input_stream, substr, ',' );
-        if (std::regex_match(substr, matches, pattern)) {
-          auto next_point = curr_point;
-//          std::cout << "> " << matches[1].str() << " -> " << matches[2].str() << std::endl;
-          switch (matches[1].str().at(0)) {
-            case 'U': next_point.second -= stoi(matches[2]); break;
-            case 'D': next_point.second += stoi(matches[2]); break;
-            case 'L': next_point.first -= stoi(matches[2]); break;
-            case 'R': next_point.first += stoi(matches[2]); break;
-            default: {
-              assert(0);
-            }
+      while (!scanner.at_end()) {
+        char direction = scanner.peek();
+        scanner.skip(direction);
+        int distance = 0;
+        if (!scanner.read_int(distance)) assert(0);
+        auto next_point = curr_point;
+//        aoc::out() << "> " << direction << " -> " << distance << std::endl;
+        switch (direction) {
+          case 'U': next_point.second -= distance; break;
+          case 'D': next_point.second += distance; break;
+          case 'L': next_point.first -= distance; break;
+          case 'R': next_point.first += distance; break;
+          default: {
+            assert(0);
           }
-          segments.emplace_back(curr_point, next_point);
-          curr_point = next_point;
-        } else {
-          assert(0);
         }
+        segments.emplace_back(curr_point, next_point);
+        curr_point = next_point;
+        scanner.skip(',');
       }
     }
   };
@@ -130,6 +127,7 @@ namespace day3 {
   }
 
   int find_closest_intersection_point_distance(const wire_t &wire1, const wire_t &wire2) {
+    AOC_SPAN("solve");
     // For each wire1 x wire2 segment intersections, keep track of closest to origin
     // Compute manhattan distance for closest pair
     int closest_distance_to_intersection = std::numeric_limits<int>::max();
@@ -138,8 +136,8 @@ namespace day3 {
         auto intersection_pt = find_intersection(wire1_segment, wire2_segment);
         auto distance = get_manhattan_dist_from_origin(intersection_pt);
 //        if (distance > 0) {
-//          std::cout << "Found intersection at " << intersection_pt;
-//          std::cout << "    " << wire1_segment << " <-> " << wire2_segment << std::endl;
+//          aoc::out() << "Found intersection at " << intersection_pt;
+//          aoc::out() << "    " << wire1_segment << " <-> " << wire2_segment << std::endl;
 //        }
         if (distance > 0 && distance < closest_distance_to_intersection) {
           closest_distance_to_intersection = distance;
@@ -150,6 +148,7 @@ namespace day3 {
   }
 
   int find_minimum_intersection_steps(const wire_t &wire1, const wire_t &wire2) {
+    AOC_SPAN("solve");
     int minimum_steps_to_intersection = std::numeric_limits<int>::max();
     int wire1_steps = 0;
     for (auto& wire1_segment : wire1.segments) {
@@ -173,13 +172,15 @@ namespace day3 {
   }
 
   void read_data(std::vector<wire_t> &outdata, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    std::string str;
-    while (std::getline(input_stream, str))
-    {
+    AOC_SPAN("parse");
+    bool loaded = aoc::for_each_line(filepath, [&](std::string_view line) {
       wire_t wire;
-      wire.initialize(str);
+      wire.initialize(line);
       outdata.push_back(wire);
+    });
+    if (!loaded) {
+      std::cerr << "ERROR: Could not load wires from " << filepath << std::endl;
+      assert(0);
     }
   }
 
@@ -205,7 +206,7 @@ namespace day3 {
 
     std::vector<wire_t> wires;
     read_data(wires, "data/day3/problem1/input.txt");
-    std::cout << "Result : " << find_closest_intersection_point_distance(wires[0], wires[1]) << std::endl;
+    aoc::out() << "Result : " << find_closest_intersection_point_distance(wires[0], wires[1]) << std::endl;
   }
 
   void problem2() {
@@ -218,7 +219,7 @@ namespace day3 {
 
     std::vector<wire_t> wires;
     read_data(wires, "data/day3/problem2/input.txt");
-    std::cout << "Result : " << find_minimum_intersection_steps(wires[0], wires[1]) << std::endl;
+    aoc::out() << "Result : " << find_minimum_intersection_steps(wires[0], wires[1]) << std::endl;
 
 
   }
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <numeric>
 
+#include "output_capture.h"
+#include "shard.h"
+
 namespace day4 {
 
   using password_t = char[7];
@@ -69,18 +72,23 @@ namespace day4 {
   long get_num_password_matches(
       const password_t &start_value, const password_t &end_value,
       const std::function<bool(const password_t &)>& check_fn,
-      bool trace = false
+      bool trace = false,
+      const aoc::shard_t &shard = {}
   ) {
     long num_matches = 0;
     password_t temp_value;
     strncpy(temp_value, start_value, 6);
-    while (strncmp(temp_value, end_value, 6) <= 0) {
-      if (trace) std::cout << "Checking " << temp_value;
+    for (uint64_t candidate_idx = 0; strncmp(temp_value, end_value, 6) <= 0; candidate_idx++) {
+      if (!shard.owns(candidate_idx)) {
+        increment_password(temp_value);
+        continue;
+      }
+      if (trace) aoc::out() << "Checking " << temp_value;
       if (check_fn(temp_value)) {
-        if (trace) std::cout << "\t YES";
+        if (trace) aoc::out() << "\t YES";
         num_matches++;
       }
-      if (trace) std::cout << std::endl;
+      if (trace) aoc::out() << std::endl;
       increment_password(temp_value);
     }
     return num_matches;
@@ -89,10 +97,7 @@ namespace day4 {
   void problem1() {
     assert(get_num_password_matches("111110", "111112", does_password_match, true) == 2);
 
-    std::cout
-        << "Result : "
-        << get_num_password_matches("235741", "706948", does_password_match)
-        << std::endl;
+    aoc::report_result(4, 1, aoc::REDUCE_Sum, get_num_password_matches("235741", "706948", does_password_match, false, aoc::get_shard()));
   }
 
   void problem2() {
@@ -100,10 +105,7 @@ namespace day4 {
     assert(!has_a_two_digit_group("123444"));
     assert(has_a_two_digit_group("111122"));
 
-    std::cout
-        << "Result : "
-        << get_num_password_matches("235741", "706948", does_password_match_2digit_group_only)
-        << std::endl;
+    aoc::report_result(4, 2, aoc::REDUCE_Sum, get_num_password_matches("235741", "706948", does_password_match_2digit_group_only, false, aoc::get_shard()));
   }
 
 } // namespace day1
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 
+#include "intcode_image.h"
+#include "output_capture.h"
+#include "trace_spans.h"
+
 namespace day5 {
 
   const bool DEEP_TRACE = false;
@@ -11,6 +14,17 @@ namespace day5 {
   using int_code_program_t = std::vector<long>;
   using output_handler_t = std::function<void(long)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t  _program_code;
     int                 _instruction_pointer = 0;
@@ -38,11 +52,11 @@ namespace day5 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -51,7 +65,7 @@ namespace day5 {
       long  _param_mode_1;
       long  _param_mode_2;
 
-      explicit instruction_t(long instruction_value, bool trace = false) {
+      explicit instruction_t(long instruction_value) {
         /*
           ABCDE
            1002
@@ -66,7 +80,7 @@ namespace day5 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace) std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2 << "]" << std::endl;
+        if constexpr (trace_policy_t::enabled) aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2 << "]" << std::endl;
       }
     };
 
@@ -79,8 +93,8 @@ namespace day5 {
       }
     }
 
-    void step(const output_handler_t& output_handler, bool trace = false) {
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+    void step(const output_handler_t& output_handler) {
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -89,9 +103,9 @@ namespace day5 {
           auto result = val0 + val1;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -101,18 +115,18 @@ namespace day5 {
           auto result = val0 * val1;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto write_address = read_param_value(_instruction_pointer, 0, 1);
           _program_code[write_address] = _input;
-          if (trace) std::cout << "WROTE " << _input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "WROTE " << _input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -120,7 +134,7 @@ namespace day5 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 5: {
@@ -128,12 +142,12 @@ namespace day5 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           auto val1 = read_param_value(_instruction_pointer, 1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -141,12 +155,12 @@ namespace day5 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           auto val1 = read_param_value(_instruction_pointer, 1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
             _instruction_pointer += 3;
           }
-//          if (trace) print_program_code();
+//          if constexpr (trace_policy_t::enabled) print_program_code();
           break;
         }
         case 7: {
@@ -156,9 +170,9 @@ namespace day5 {
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -168,15 +182,15 @@ namespace day5 {
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return;
         }
         default: {
@@ -186,44 +200,44 @@ namespace day5 {
       }
     }
 
-    void run(const output_handler_t& output_handler, bool trace = false) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+    void run(const output_handler_t& output_handler) {
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted) {
-        step(output_handler, trace);
+        step(output_handler);
       }
     }
 
   };
 
   void read_data(std::vector<long> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
   void problem1() {
-    int_code_program_state_t program_state;
+    int_code_program_state_t<> program_state;
     read_data(program_state._program_code, "data/day5/problem1/input.txt");
     program_state.set_input(1);
     program_state.run([](long value) {
-      std::cout << "OUTPUT: " << value << std::endl;
+      aoc::out() << "OUTPUT: " << value << std::endl;
     });
   }
 
   void problem2() {
-    int_code_program_state_t program_state;
+    int_code_program_state_t<> program_state;
     read_data(program_state._program_code, "data/day5/problem2/input.txt");
     program_state.set_input(5);
     program_state.run([](long value) {
-      std::cout << "OUTPUT: " << value << std::endl;
+      aoc::out() << "OUTPUT: " << value << std::endl;
     });
   }
 
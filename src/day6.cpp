@@ -2,14 +2,16 @@
 #include <utility>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
-#include <regex>
 #include <map>
 #include <list>
 #include <memory>
 #include <array>
 
+#include "output_sink.h"
+#include "text_scanner.h"
+#include "trace_spans.h"
+
 namespace day6 {
 
   constexpr bool trace_read = false;
@@ -18,22 +20,25 @@ namespace day6 {
   struct orbit_defn_t {
     std::string parent, child;
 
-    friend std::istream &operator>>(std::istream &in, orbit_defn_t &orbit_defn) {
+    void parse(std::string_view value) {
       // E.g.: AAA)BBB
-      std::string line;
-      getline(in, line);
-
-      std::regex pattern(R"((.+)\)(.+))");
-      std::smatch matches;
-
-      if (!std::regex_search(line, matches, pattern)) {
+      aoc::text_scanner_t scanner(value);
+      auto parent_name = scanner.read_until(')');
+      if (!scanner.skip(')') || parent_name.empty() || scanner.at_end()) {
         throw new std::invalid_argument("Cannot parse step rule!");
       }
+      scanner.skip_whitespace();
 
-      orbit_defn.parent = matches[1].str();
-      orbit_defn.child = matches[2].str();
+      parent = parent_name;
+      child = scanner.read_until(' ');
 
-      if (trace_read) std::cout << "Read " << orbit_defn.child << ")" << orbit_defn.parent << std::endl;
+      if (trace_read) aoc::out() << "Read " << child << ")" << parent << std::endl;
+    }
+
+    friend std::istream &operator>>(std::istream &in, orbit_defn_t &orbit_defn) {
+      std::string line;
+      getline(in, line);
+      orbit_defn.parse(line);
       return in;
     }
   };
@@ -66,7 +71,7 @@ namespace day6 {
     std::shared_ptr<orbiting_object_t> find_or_create_orbiting_object(std::string name, bool trace = false) {
       auto orbit_iter = orbiting_objects.find(name);
       if (orbit_iter == orbiting_objects.end()) {
-        if (trace) std::cout << "Creating " << name << std::endl;
+        if (trace) aoc::out() << "Creating " << name << std::endl;
         auto new_object = std::make_shared<orbiting_object_t>(name);
         orbiting_objects[name] = new_object;
         return new_object;
@@ -94,15 +99,16 @@ namespace day6 {
           num_total_orbits += get_num_total_orbits_helper(curr_orbit_depth, child, trace);
         }
       }
-      if (trace) std::cout << "Num orbits for " << orbiting_object->_name << " = " << curr_orbit_depth << std::endl;
+      if (trace) aoc::out() << "Num orbits for " << orbiting_object->_name << " = " << curr_orbit_depth << std::endl;
       return num_total_orbits - 1;
     }
 
     long get_num_total_orbits(bool trace = false) {
+      AOC_SPAN("solve");
       auto universal_center_of_mass = find_or_create_orbiting_object("COM");
       assert(universal_center_of_mass);
       auto total_orbits = get_num_total_orbits_helper(0, universal_center_of_mass, trace);
-      if (trace) std::cout << "Total orbits: " << total_orbits << std::endl;
+      if (trace) aoc::out() << "Total orbits: " << total_orbits << std::endl;
       return total_orbits;
     }
 
@@ -119,18 +125,19 @@ namespace day6 {
     }
 
     long get_num_orbital_transfer_steps(const std::string& source_name, const std::string& destination_name, bool trace = false) {
+      AOC_SPAN("solve");
       // Get ancestor list for source, dest
       auto source_ancestor_orbits = get_ancestor_orbits_for(source_name);
       if (trace) {
-        std::cout << "Ancestors for " << source_name << " => ";
-        for (auto ancestor_orbit : source_ancestor_orbits) std::cout << ancestor_orbit->_name << " ";
-        std::cout << std::endl;
+        aoc::out() << "Ancestors for " << source_name << " => ";
+        for (auto ancestor_orbit : source_ancestor_orbits) aoc::out() << ancestor_orbit->_name << " ";
+        aoc::out() << std::endl;
       }
       auto destination_ancestor_orbits = get_ancestor_orbits_for(destination_name);
       if (trace) {
-        std::cout << "Ancestors for " << destination_name << " => ";
-        for (auto ancestor_orbit : destination_ancestor_orbits) std::cout << ancestor_orbit->_name << " ";
-        std::cout << std::endl;
+        aoc::out() << "Ancestors for " << destination_name << " => ";
+        for (auto ancestor_orbit : destination_ancestor_orbits) aoc::out() << ancestor_orbit->_name << " ";
+        aoc::out() << std::endl;
       }
       // Back to front, search for common ancestor and return sum of steps to that common ancestor
       long source_transfer_steps = 0;
@@ -150,16 +157,21 @@ namespace day6 {
   };
 
   void read_data(orbital_map_t &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
+    AOC_SPAN("parse + build orbital_map_t");
     orbit_defn_t orbit_defn;
-    while (!input_stream.eof()) {
-      input_stream >> orbit_defn;
+    bool loaded = aoc::for_each_line(filepath, [&](std::string_view line) {
+      orbit_defn.parse(line);
       outdata.add_orbit(orbit_defn, trace);
+    });
+    if (!loaded) {
+      std::cerr << "ERROR: Could not load orbits from " << filepath << std::endl;
+      assert(0);
     }
   }
 
   void problem1() {
     {
+      bool trace = trace_test && aoc::show_progress();
       orbital_map_t test;
       std::vector<orbit_defn_t> defns = {
           {"COM", "B"},
@@ -174,19 +186,20 @@ namespace day6 {
           {"J",   "K"},
           {"K",   "L"},
       };
-      for (auto &defn : defns) test.add_orbit(defn, trace_test);
-      std::cout << test << std::endl;
-      assert(test.get_num_total_orbits(trace_test) == 42);
-      std::cout << std::endl;
+      for (auto &defn : defns) test.add_orbit(defn, trace);
+      if (trace) aoc::out() << test << std::endl;
+      assert(test.get_num_total_orbits(trace) == 42);
+      if (trace) aoc::out() << std::endl;
     }
 
     orbital_map_t input;
     read_data(input, "data/day6/problem1/input.txt");
-    std::cout << "Result : " << input.get_num_total_orbits() << std::endl;
+    aoc::out() << "Result : " << input.get_num_total_orbits() << std::endl;
   }
 
   void problem2() {
     {
+      bool trace = trace_test && aoc::show_progress();
       orbital_map_t test;
       std::vector<orbit_defn_t> defns = {
           {"COM", "B"},
@@ -203,15 +216,15 @@ namespace day6 {
           {"K",   "YOU"},
           {"I",   "SAN"},
       };
-      for (auto &defn : defns) test.add_orbit(defn, trace_test);
-      std::cout << test << std::endl;
-      assert(test.get_num_orbital_transfer_steps("YOU", "SAN", trace_test) == 4);
-      std::cout << std::endl;
+      for (auto &defn : defns) test.add_orbit(defn, trace);
+      if (trace) aoc::out() << test << std::endl;
+      assert(test.get_num_orbital_transfer_steps("YOU", "SAN", trace) == 4);
+      if (trace) aoc::out() << std::endl;
     }
 
     orbital_map_t input;
     read_data(input, "data/day6/problem2/input.txt");
-    std::cout << "Result : " << input.get_num_orbital_transfer_steps("YOU", "SAN") << std::endl;
+    aoc::out() << "Result : " << input.get_num_orbital_transfer_steps("YOU", "SAN") << std::endl;
   }
 
 } // namespace day1
@@ -2,9 +2,13 @@
 #include <utility>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 
+#include "intcode_image.h"
+#include "output_sink.h"
+#include "shard.h"
+#include "trace_spans.h"
+
 namespace day7 {
 
   const bool DEEP_TRACE = false;
@@ -15,6 +19,17 @@ namespace day7 {
   using input_handler_t = std::function<unit_t(void)>;
   using output_handler_t = std::function<void(unit_t)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     int _instruction_pointer = 0;
@@ -27,11 +42,11 @@ namespace day7 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -40,7 +55,7 @@ namespace day7 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -55,8 +70,8 @@ namespace day7 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -73,11 +88,10 @@ namespace day7 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -86,9 +100,9 @@ namespace day7 {
           auto result = val0 + val1;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -98,9 +112,9 @@ namespace day7 {
           auto result = val0 * val1;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
@@ -108,9 +122,9 @@ namespace day7 {
           auto write_address = read_param_value(_instruction_pointer, 0, 1);
           auto input = input_handler();
           _program_code[write_address] = input;
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -118,8 +132,8 @@ namespace day7 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return false;
           break;
         }
@@ -128,13 +142,13 @@ namespace day7 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           auto val1 = read_param_value(_instruction_pointer, 1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -142,13 +156,13 @@ namespace day7 {
           auto val0 = read_param_value(_instruction_pointer, 0, instruction._param_mode_0);
           auto val1 = read_param_value(_instruction_pointer, 1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-//          if (trace) print_program_code();
+//          if constexpr (trace_policy_t::enabled) print_program_code();
           break;
         }
         case 7: {
@@ -158,9 +172,9 @@ namespace day7 {
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -170,16 +184,16 @@ namespace day7 {
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = read_param_value(_instruction_pointer, 2, 1);
           _program_code[write_address] = result;
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -191,31 +205,31 @@ namespace day7 {
       return true;
     }
 
-    void run(const input_handler_t &input_handler, const output_handler_t &output_handler, bool break_on_output, bool trace = false) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+    void run(const input_handler_t &input_handler, const output_handler_t &output_handler, bool break_on_output) {
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted) {
-        auto output_occurred = step(input_handler, output_handler, trace);
+        auto output_occurred = step(input_handler, output_handler);
         if (!output_occurred) return;
       }
     }
   };
 
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
   struct amplifier_t {
-    int_code_program_state_t  _program_state;
+    int_code_program_state_t<>  _program_state;
     unit_t                    _phase_setting = -1;
     unit_t                    _input_count = 0;
     unit_t                    _output = -1;
@@ -226,15 +240,14 @@ namespace day7 {
 
       _program_state.run(
           [&]() -> unit_t {
-            if (trace) std::cout << "Requesting [" << _input_count << "] => ";
+            if (trace) aoc::out() << "Requesting [" << _input_count << "] => ";
             unit_t ret_value = (_input_count == 0) ? _phase_setting : input_value;
-            if (trace) std::cout << ret_value << std::endl;
+            if (trace) aoc::out() << ret_value << std::endl;
             _input_count++;
             return ret_value;
           },
           [&](unit_t value) { _output = value; },
-          break_on_output,
-          trace
+          break_on_output
       );
 
       return _output;
@@ -249,9 +262,9 @@ namespace day7 {
       : _phase_settings(std::move(phase_settings)) {}
     constexpr unit_t get_num_phase_settings() const { return _phase_settings.size(); }
     friend std::ostream& operator << (std::ostream& out, const phase_setting_sequence_t &phase_setting_seq) {
-      std::cout << "[";
-      for (auto phase_setting : phase_setting_seq._phase_settings) std::cout << phase_setting;
-      std::cout << "]";
+      aoc::out() << "[";
+      for (auto phase_setting : phase_setting_seq._phase_settings) aoc::out() << phase_setting;
+      aoc::out() << "]";
       return out;
     }
     unit_t operator[] (size_t index) const {
@@ -274,18 +287,21 @@ namespace day7 {
 
     unit_t prev_amplifier_output = 0;
     for (unit_t amplifier_idx = 0; amplifier_idx < amplifiers.size(); amplifier_idx++) {
-      if (trace) std::cout << "\n**** AMP " << amplifier_idx << std::endl;
+      if (trace) aoc::out() << "\n**** AMP " << amplifier_idx << std::endl;
       auto& amplifier = amplifiers[amplifier_idx];
       prev_amplifier_output = amplifier.process(prev_amplifier_output, true, trace);
     }
     return prev_amplifier_output;
   }
 
-  unit_t get_highest_possible_thruster_signal(const int_code_program_t &program, bool trace = false) {
+  // Returns -1 if the shard owns no phase setting sequence
+  unit_t get_highest_possible_thruster_signal(const int_code_program_t &program, bool trace = false, const aoc::shard_t &shard = {}) {
     unit_t max_thruster_signal = -1;
     phase_setting_sequence_t phase_setting_seq{{0, 1, 2, 3, 4}};
+    uint64_t permutation_idx = 0;
     do {
-      std::cout << "Testing Phase Seq: " << phase_setting_seq << std::endl;
+      if (!shard.owns(permutation_idx++)) continue;
+      if (aoc::show_progress()) aoc::out() << "Testing Phase Seq: " << phase_setting_seq << std::endl;
       auto thruster_signal = get_thruster_signal(phase_setting_seq, program, trace);
       if (thruster_signal > max_thruster_signal) max_thruster_signal = thruster_signal;
     } while (phase_setting_seq.next());
@@ -307,9 +323,9 @@ namespace day7 {
     bool signal_ok = true;
     while (signal_ok) {
       auto &amplifier = amplifiers[amplifier_idx];
-      if (trace) std::cout << "\n[" << step << "] ** AMP " << amplifier_idx;
+      if (trace) aoc::out() << "\n[" << step << "] ** AMP " << amplifier_idx;
       prev_amplifier_output = amplifier.process(prev_amplifier_output, true, trace);
-      if (trace) std::cout << " (HALTED = " << (amplifier._program_state._halted) << ") OUTPUT: " << prev_amplifier_output << std::endl;
+      if (trace) aoc::out() << " (HALTED = " << (amplifier._program_state._halted) << ") OUTPUT: " << prev_amplifier_output << std::endl;
       amplifier_idx++;
       if (amplifier_idx == amplifiers.size()) {
         signal_ok = !amplifier._program_state._halted;
@@ -321,11 +337,14 @@ namespace day7 {
     return prev_amplifier_output;
   }
 
-  unit_t get_highest_possible_thruster_signal_mode2(const int_code_program_t &program, bool trace = false) {
+  // Returns -1 if the shard owns no phase setting sequence
+  unit_t get_highest_possible_thruster_signal_mode2(const int_code_program_t &program, bool trace = false, const aoc::shard_t &shard = {}) {
     unit_t max_thruster_signal = -1;
     phase_setting_sequence_t phase_setting_seq{{5, 6, 7, 8, 9}};
+    uint64_t permutation_idx = 0;
     do {
-      std::cout << "Testing Phase Seq: " << phase_setting_seq << std::endl;
+      if (!shard.owns(permutation_idx++)) continue;
+      if (aoc::show_progress()) aoc::out() << "Testing Phase Seq: " << phase_setting_seq << std::endl;
       auto thruster_signal = get_thruster_signal_mode2(phase_setting_seq, program, trace);
       if (thruster_signal > max_thruster_signal) max_thruster_signal = thruster_signal;
     } while (phase_setting_seq.next());
@@ -336,19 +355,26 @@ namespace day7 {
     {
       int_code_program_t program = {3,15,3,16,1002,16,10,16,1,16,15,15,4,15,99,0,0};
       phase_setting_sequence_t phase_setting_seq({4,3,2,1,0});
-      std::cout << "Max thruster signal: " << get_thruster_signal(phase_setting_seq, program) << std::endl;
+      auto thruster_signal = get_thruster_signal(phase_setting_seq, program);
+      if (aoc::show_progress()) aoc::out() << "Max thruster signal: " << thruster_signal << std::endl;
     }
 
     {
       int_code_program_t program = {3,23,3,24,1002,24,10,24,1002,23,-1,23,
                                     101,5,23,23,1,24,23,23,4,23,99,0,0};
       phase_setting_sequence_t phase_setting_seq({0,1,2,3,4});
-      std::cout << "Max thruster signal: " << get_thruster_signal(phase_setting_seq, program) << std::endl;
+      auto thruster_signal = get_thruster_signal(phase_setting_seq, program);
+      if (aoc::show_progress()) aoc::out() << "Max thruster signal: " << thruster_signal << std::endl;
     }
 
     int_code_program_t program;
     read_data(program, "data/day7/problem1/input.txt");
-    std::cout << "Result : " << get_highest_possible_thruster_signal(program) << std::endl;
+    auto max_thruster_signal = get_highest_possible_thruster_signal(program, false, aoc::get_shard());
+    if (max_thruster_signal < 0) {
+      aoc::report_no_candidate(7, 1, aoc::REDUCE_Max);
+    } else {
+      aoc::report_result(7, 1, aoc::REDUCE_Max, max_thruster_signal);
+    }
   }
 
   void problem2() {
@@ -356,12 +382,18 @@ namespace day7 {
       int_code_program_t program = {3,26,1001,26,-4,26,3,27,1002,27,2,27,1,27,26,
                                     27,4,27,1001,28,-1,28,1005,28,6,99,0,0,5};
       phase_setting_sequence_t phase_setting_seq({9,8,7,6,5});
-      std::cout << "Max thruster signal: " << get_thruster_signal_mode2(phase_setting_seq, program) << std::endl;
+      auto thruster_signal = get_thruster_signal_mode2(phase_setting_seq, program);
+      if (aoc::show_progress()) aoc::out() << "Max thruster signal: " << thruster_signal << std::endl;
     }
 
     int_code_program_t program;
     read_data(program, "data/day7/problem2/input.txt");
-    std::cout << "Result : " << get_highest_possible_thruster_signal_mode2(program) << std::endl;
+    auto max_thruster_signal = get_highest_possible_thruster_signal_mode2(program, false, aoc::get_shard());
+    if (max_thruster_signal < 0) {
+      aoc::report_no_candidate(7, 2, aoc::REDUCE_Max);
+    } else {
+      aoc::report_result(7, 2, aoc::REDUCE_Max, max_thruster_signal);
+    }
   }
 
 } // namespace day1
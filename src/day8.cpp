@@ -1,12 +1,16 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 
+#include "digit_stream.h"
+#include "micro_bench.h"
+#include "output_capture.h"
+#include "trace_spans.h"
+
 namespace day8 {
 
-  using image_layer_t = std::vector<long>;
+  using image_layer_t = std::vector<uint8_t>;
   struct image_t {
     enum pixel_e {
       BLACK = 0,
@@ -53,9 +57,9 @@ namespace day8 {
       for (long pixel_idx = 0; pixel_idx < image._merged.size(); pixel_idx++) {
         auto pixel = image._merged[pixel_idx];
         switch (pixel) {
-          case pixel_e::BLACK: std::cout << ' '; break;
-          case pixel_e::WHITE: std::cout << "█"; break;
-          case pixel_e::TRANSPARENT: std::cout << ' '; break;
+          case pixel_e::BLACK: aoc::out() << ' '; break;
+          case pixel_e::WHITE: aoc::out() << "█"; break;
+          case pixel_e::TRANSPARENT: aoc::out() << ' '; break;
           default: assert(0);
         }
         if ((pixel_idx % image._width) == (image._width - 1)) out << std::endl;
@@ -66,30 +70,46 @@ namespace day8 {
   };
 
   void read_data(image_t &image, const char *filepath) {
-    std::ifstream input_stream(filepath);
-    char c;
-    image_layer_t temp;
+    AOC_SPAN("parse");
+    aoc::digit_buffer_t digits;
+    if (!aoc::load_digits(filepath, digits)) {
+      std::cerr << "ERROR: Could not load image from " << filepath << std::endl;
+      assert(0);
+    }
     long max_layer_values = image._width * image._height;
-    while (input_stream >> c) {
-      temp.push_back(c - '0');
-      if (temp.size() == max_layer_values) {
-        image.add_layer(temp);
-        temp.clear();
-      }
+    for (long offset = 0; offset + max_layer_values <= digits.size(); offset += max_layer_values) {
+      image.add_layer(image_layer_t(digits.begin() + offset, digits.begin() + offset + max_layer_values));
     }
   }
 
   void problem1() {
     image_t input(25, 6);
     read_data(input, "data/day8/problem1/input.txt");
-    std::cout << "Result : " << input.calculate_checksum() << std::endl;
+    aoc::out() << "Result : " << input.calculate_checksum() << std::endl;
   }
 
   void problem2() {
     image_t input(25, 6);
     read_data(input, "data/day8/problem2/input.txt");
-    std::cout << "Result : " << std::endl;
-    std::cout << input << std::endl;
+    aoc::out() << "Result : " << std::endl;
+    aoc::out() << input << std::endl;
+  }
+
+  void register_kernels(aoc::kernel_registry_t &registry) {
+    auto digits = std::make_shared<aoc::digit_buffer_t>();
+    if (!aoc::load_digits("data/day8/problem1/input.txt", *digits)) return;
+    auto layers = std::make_shared<std::vector<image_layer_t>>();
+    for (size_t offset = 0; offset + 25 * 6 <= digits->size(); offset += 25 * 6) {
+      layers->emplace_back(digits->begin() + offset, digits->begin() + offset + 25 * 6);
+    }
+    // One iteration merges every layer of the puzzle input into a fresh image
+    registry.push_back({"day8 image_t::add_layer (all layers)", [layers](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; i++) {
+        image_t image(25, 6);
+        for (auto &layer : *layers) image.add_layer(layer);
+        aoc::do_not_optimize(image._merged.data());
+      }
+    }});
   }
 
 } // namespace day1
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <fstream>
 #include <numeric>
 
+#include "intcode_image.h"
+#include "micro_bench.h"
+#include "output_sink.h"
+#include "trace_spans.h"
+
 namespace day9 {
 
   const bool DEEP_TRACE = false;
@@ -14,6 +18,17 @@ namespace day9 {
   using input_handler_t = std::function<unit_t(void)>;
   using output_handler_t = std::function<void(unit_t)>;
 
+  // Trace policies for the IntCode engine. Tracing is selected at compile time so the default (no_trace_t)
+  // build carries no trace branches in the step loop. Use int_code_program_state_t<text_trace_t> to debug.
+  struct no_trace_t {
+    static constexpr bool enabled = false;
+  };
+
+  struct text_trace_t {
+    static constexpr bool enabled = true;
+  };
+
+  template<typename trace_policy_t = no_trace_t>
   struct int_code_program_state_t {
     int_code_program_t _program_code;
     unit_t _instruction_pointer = 0;
@@ -27,11 +42,11 @@ namespace day9 {
     }
 
     void print_program_code() {
-      std::cout << "> ";
+      aoc::out() << "> ";
       for (auto value : _program_code) {
-        std::cout << value << ",";
+        aoc::out() << value << ",";
       }
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
     struct instruction_t {
@@ -40,7 +55,7 @@ namespace day9 {
       unit_t _param_mode_1;
       unit_t _param_mode_2;
 
-      explicit instruction_t(unit_t instruction_value, bool trace = false) {
+      explicit instruction_t(unit_t instruction_value) {
         /*
           ABCDE
            1002
@@ -55,8 +70,8 @@ namespace day9 {
         _param_mode_0 = (instruction_value / 100) % 10;
         _param_mode_1 = (instruction_value / 1000) % 10;
         _param_mode_2 = (instruction_value / 10000) % 10;
-        if (trace)
-          std::cout << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
+        if constexpr (trace_policy_t::enabled)
+          aoc::out() << "\tOPCODE: " << _opcode << " [" << _param_mode_0 << "," << _param_mode_1 << "," << _param_mode_2
                     << "]" << std::endl;
       }
     };
@@ -115,11 +130,10 @@ namespace day9 {
     // Returns true if output occurred
     bool step(
         const input_handler_t &input_handler,
-        const output_handler_t &output_handler,
-        bool trace = false
+        const output_handler_t &output_handler
     ) {
-      if (trace) std::cout << "\tIP=" << _instruction_pointer;
-      instruction_t instruction(_program_code[_instruction_pointer], trace);
+      if constexpr (trace_policy_t::enabled) aoc::out() << "\tIP=" << _instruction_pointer;
+      instruction_t instruction(_program_code[_instruction_pointer]);
       switch (instruction._opcode) {
         case 1: {
           // ADD
@@ -127,9 +141,9 @@ namespace day9 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 + val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADD: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 2: {
@@ -138,18 +152,18 @@ namespace day9 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = val0 * val1;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tMUL: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 3: {
           // INPUT
           auto input = input_handler();
           auto write_address = write_value2(0, instruction._param_mode_0, input);
-          if (trace) std::cout << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tINPUT: WROTE " << input << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 4: {
@@ -157,8 +171,8 @@ namespace day9 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           output_handler(val0);
           _instruction_pointer += 2;
-          if (trace) std::cout << "\t\tOUTPUT => " << val0 << std::endl;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tOUTPUT => " << val0 << std::endl;
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           return true;
           break;
         }
@@ -167,13 +181,13 @@ namespace day9 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 != 0) {
-            if (trace) std::cout << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 6: {
@@ -181,13 +195,13 @@ namespace day9 {
           auto val0 = read_param_value(0, instruction._param_mode_0);
           auto val1 = read_param_value(1, instruction._param_mode_1);
           if (val0 == 0) {
-            if (trace) std::cout << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: SET IP from " << _instruction_pointer << " to " << val1 << std::endl;
             _instruction_pointer = val1;
           } else {
-            if (trace) std::cout << "\t\tJNE: NO CHANGE" << std::endl;
+            if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tJNE: NO CHANGE" << std::endl;
             _instruction_pointer += 3;
           }
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 7: {
@@ -196,9 +210,9 @@ namespace day9 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 < val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tLT: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 8: {
@@ -207,25 +221,25 @@ namespace day9 {
           auto val1 = read_param_value(1, instruction._param_mode_1);
           auto result = (val0 == val1) ? 1 : 0;
           auto write_address = write_value2(2, instruction._param_mode_2, result);
-          if (trace) std::cout << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tEQ: WROTE " << result << " to ADDR " << write_address << std::endl;
           _instruction_pointer += 4;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 9: {
           // ADJ RELBASE
           auto val0 = read_param_value(0, instruction._param_mode_0);
           _relative_base_pointer = _relative_base_pointer + val0;
-          if (trace) std::cout << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tADJ RELBASE: CHANGED TO " << _relative_base_pointer << std::endl;
           _instruction_pointer += 2;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         case 99: {
           // HALT
-          if (trace) std::cout << "\t\tHALTED" << std::endl;
+          if constexpr (trace_policy_t::enabled) aoc::out() << "\t\tHALTED" << std::endl;
           _halted = true;
-          if (trace && DEEP_TRACE) print_program_code();
+          if constexpr (trace_policy_t::enabled && DEEP_TRACE) print_program_code();
           break;
         }
         default: {
@@ -240,77 +254,113 @@ namespace day9 {
     void run(
         const input_handler_t &input_handler,
         const output_handler_t &output_handler,
-        bool break_on_output = false,
-        bool trace = false
+        bool break_on_output = false
     ) {
-      if (trace) {
-        std::cout << "\nRunning program.." << std::endl;
+      if constexpr (trace_policy_t::enabled) {
+        aoc::out() << "\nRunning program.." << std::endl;
         print_program_code();
       }
       while (!_halted) {
-        auto output_occured = step(input_handler, output_handler, trace);
+        auto output_occured = step(input_handler, output_handler);
         if (output_occured && break_on_output) return;
       }
     }
   };
 
   void read_data(std::vector<unit_t> &outdata, const char *filepath, bool trace = false) {
-    std::ifstream input_stream(filepath);
-    while( input_stream.good() )
-    {
-      std::string substr;
-      getline( input_stream, substr, ',' );
-      if (trace) std::cout << "READ: " << substr << std::endl;
-      outdata.push_back( std::stol(substr) );
+    AOC_SPAN("parse");
+    if (!aoc::intcode_image::load(outdata, filepath)) {
+      std::cerr << "ERROR: Could not load program from " << filepath << std::endl;
+      assert(0);
+    }
+    if (trace) {
+      for (auto value : outdata) aoc::out() << "READ: " << value << std::endl;
     }
   }
 
   void problem1() {
-    {
-      int_code_program_state_t state;
+    if (aoc::show_progress()) {
+      int_code_program_state_t<> state;
       state._program_code = {109,1,204,-1,1001,100,1,100,1008,100,16,101,1006,101,0,99};
       state.run(
           []() -> unit_t { return 1; },
-          [](unit_t value) { std::cout << value << ","; }
+          [](unit_t value) { aoc::out() << value << ","; }
       );
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
-    {
-      int_code_program_state_t state;
+    if (aoc::show_progress()) {
+      int_code_program_state_t<> state;
       state._program_code = {1102,34915192,34915192,7,4,7,99,0};
       state.run(
           []() -> unit_t { return 1; },
-          [](unit_t value) { std::cout << value << ","; }
+          [](unit_t value) { aoc::out() << value << ","; }
       );
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
-    {
-      int_code_program_state_t state;
+    if (aoc::show_progress()) {
+      int_code_program_state_t<> state;
       state._program_code = {104,1125899906842624,99};
       state.run(
           []() -> unit_t { return 1; },
-          [](unit_t value) { std::cout << value << ","; }
+          [](unit_t value) { aoc::out() << value << ","; }
       );
-      std::cout << std::endl;
+      aoc::out() << std::endl;
     }
 
-    std::cout << "TEST MODE" << std::endl;
-    int_code_program_state_t input;
+    aoc::out() << "TEST MODE" << std::endl;
+    int_code_program_state_t<> input;
     read_data(input._program_code, "data/day9/problem1/input.txt");
     input.run(
         []() -> unit_t { return 1; },
-        [](unit_t value) { std::cout << value << std::endl; }
+        [](unit_t value) { aoc::out() << value << std::endl; }
     );
   }
 
   void problem2() {
-    std::cout << "SENSOR BOOST MODE" << std::endl;
-    int_code_program_state_t input;
+    aoc::out() << "SENSOR BOOST MODE" << std::endl;
+    int_code_program_state_t<> input;
     read_data(input._program_code, "data/day9/problem2/input.txt");
     input.run(
         []() -> unit_t { return 2; },
-        [](unit_t value) { std::cout << value << std::endl; }
+        [](unit_t value) { aoc::out() << value << std::endl; }
     );
   }
 
+  void register_kernels(aoc::kernel_registry_t &registry) {
+    // Endless loops with different opcode mixes; one iteration is one step()
+    std::vector<std::pair<std::string, int_code_program_t>> mixes = {
+        // mem[100] += 1, mem[101] = -mem[101], mem[102] = mem[100] + mem[101], jump 0
+        {"arithmetic", {1001,100,1,100, 1002,101,-1,101, 1,100,101,102, 1105,1,0}},
+        // mem[100] += 1, mem[101] = mem[100] < 1000, jump-if-true 0, mem[100] = 0, jump 0
+        {"compare/branch", {1001,100,1,100, 1007,100,1000,101, 1005,101,0, 1101,0,0,100, 1105,1,0}},
+        // relative base 500, then loop: rb += 1, mem[rb] += 1, rb -= 1, mem[rb + 1] += mem[rb], jump 2
+        {"relative base", {109,500, 109,1, 21201,0,1,0, 109,-1, 22201,0,1,1, 1105,1,2}},
+    };
+    for (auto &[mix_name, program] : mixes) {
+      registry.push_back({"intcode step (" + mix_name + ")", [program = program](uint64_t iterations) {
+        static const input_handler_t input_handler = []() -> unit_t { return 0; };
+        static const output_handler_t output_handler = [](unit_t) {};
+        int_code_program_state_t<> state;
+        state.reset(program);
+        for (uint64_t i = 0; i < iterations; i++) {
+          state.step(input_handler, output_handler);
+        }
+        aoc::do_not_optimize(state._instruction_pointer);
+      }});
+    }
+
+    // One iteration runs the whole sensor boost program (problem 2), a long real world instruction stream
+    auto program = std::make_shared<int_code_program_t>();
+    if (!aoc::intcode_image::load(*program, "data/day9/problem2/input.txt")) return;
+    registry.push_back({"intcode run (day9 sensor boost)", [program](uint64_t iterations) {
+      for (uint64_t i = 0; i < iterations; i++) {
+        int_code_program_state_t<> state;
+        state.reset(*program);
+        unit_t output = 0;
+        state.run([]() -> unit_t { return 2; }, [&](unit_t value) { output = value; });
+        aoc::do_not_optimize(output);
+      }
+    }});
+  }
+
 } // namespace day1
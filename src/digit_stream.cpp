@@ -0,0 +1,73 @@
+#include "digit_stream.h"
+
+#include "input_registry.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aoc {
+
+  namespace {
+
+    bool is_whitespace(char c) {
+      return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    // Scalar path for the tail and for chunks that contain anything other than digits
+    bool decode_scalar(const char *begin, const char *end, uint8_t *&output) {
+      for (auto cursor = begin; cursor < end; cursor++) {
+        auto digit = static_cast<uint8_t>(*cursor - '0');
+        if (digit <= 9) {
+          *output++ = digit;
+        } else if (!is_whitespace(*cursor)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  } // namespace
+
+  bool decode_digits(std::string_view text, digit_buffer_t &outdigits) {
+    auto offset = outdigits.size();
+    // Every input byte produces at most one digit
+    outdigits.resize(offset + text.size());
+    uint8_t *output = outdigits.data() + offset;
+
+    const char *cursor = text.data();
+    const char *end = text.data() + text.size();
+#if defined(__SSE2__)
+    // 16 characters at a time: subtract '0' and check every lane is <= 9 (unsigned). Chunks that are all digits
+    // are stored as-is; mixed chunks (line breaks etc) fall back to the scalar path.
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    for (; cursor + 16 <= end; cursor += 16) {
+      __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor));
+      __m128i digits = _mm_sub_epi8(chars, zero_char);
+      __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(digits, nine), digits);
+      if (_mm_movemask_epi8(in_range) == 0xFFFF) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), digits);
+        output += 16;
+      } else if (!decode_scalar(cursor, cursor + 16, output)) {
+        outdigits.resize(offset);
+        return false;
+      }
+    }
+#endif
+    if (!decode_scalar(cursor, end, output)) {
+      outdigits.resize(offset);
+      return false;
+    }
+    outdigits.resize(output - outdigits.data());
+    return true;
+  }
+
+  bool load_digits(const char *filepath, digit_buffer_t &outdigits) {
+    auto digits = get_input_registry().get_parsed<digit_buffer_t>(filepath, decode_digits);
+    if (digits == nullptr) return false;
+    outdigits.insert(outdigits.end(), digits->begin(), digits->end());
+    return true;
+  }
+
+} // namespace aoc
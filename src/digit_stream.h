@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <vector>
+
+namespace aoc {
+
+  // Allocator that returns alignment-byte aligned storage, so SIMD loops over the buffer start on a cache line
+  template<typename value_t, size_t alignment>
+  struct aligned_allocator_t {
+    using value_type = value_t;
+
+    template<typename other_t>
+    struct rebind {
+      using other = aligned_allocator_t<other_t, alignment>;
+    };
+
+    aligned_allocator_t() = default;
+    template<typename other_t>
+    explicit aligned_allocator_t(const aligned_allocator_t<other_t, alignment> &) {}
+
+    value_t *allocate(size_t count) {
+      return static_cast<value_t *>(::operator new(count * sizeof(value_t), std::align_val_t(alignment)));
+    }
+
+    void deallocate(value_t *pointer, size_t) {
+      ::operator delete(pointer, std::align_val_t(alignment));
+    }
+
+    bool operator==(const aligned_allocator_t &) const { return true; }
+    bool operator!=(const aligned_allocator_t &) const { return false; }
+  };
+
+  // One byte per digit, 0-9
+  using digit_buffer_t = std::vector<uint8_t, aligned_allocator_t<uint8_t, 64>>;
+
+  // Appends the digits in text to outdigits, skipping whitespace. Returns false on any other character.
+  bool decode_digits(std::string_view text, digit_buffer_t &outdigits);
+
+  // Appends the digits of filepath to outdigits. Decoded digits are cached in the input registry.
+  bool load_digits(const char *filepath, digit_buffer_t &outdigits);
+
+} // namespace aoc
@@ -0,0 +1,101 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "input_generator.h"
+
+// Writes synthetic puzzle inputs of arbitrary size.
+// Usage: aoc_gen <day> <scale> [--seed N] [--output FILE | --data-dir DIR]
+//        aoc_gen --list
+// With --data-dir the input is written as DIR/day<N>/problem1/input.txt and problem2/input.txt, the same layout as
+// data/. Without either option it goes to stdout.
+int main(int argc, char const *argv[]) {
+  std::vector<std::string> args;
+  uint64_t seed = 2019;
+  std::string output_filepath, data_dirpath;
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+    std::string arg = argv[arg_idx];
+    bool has_value = arg_idx + 1 < argc;
+    try {
+      if (arg == "--list") {
+        for (auto &generator : aoc::get_input_generators()) {
+          std::cout << "Day " << generator._day << " : scale = " << generator._scale_unit
+                    << " (puzzle input ~" << generator._puzzle_scale << ")" << std::endl;
+        }
+        return 0;
+      } else if (arg == "--seed" && has_value) {
+        seed = std::stoull(argv[++arg_idx]);
+      } else if (arg == "--output" && has_value) {
+        output_filepath = argv[++arg_idx];
+      } else if (arg == "--data-dir" && has_value) {
+        data_dirpath = argv[++arg_idx];
+      } else if (arg.rfind("--", 0) != 0) {
+        args.push_back(arg);
+      } else {
+        std::cerr << "ERROR: Unknown option " << arg << std::endl;
+        return -1;
+      }
+    } catch (...) {
+      std::cerr << "ERROR: Invalid value for option " << arg << std::endl;
+      return -1;
+    }
+  }
+
+  if (args.size() != 2 || (!output_filepath.empty() && !data_dirpath.empty())) {
+    std::cerr << "ERROR: Usage: aoc_gen <day> <scale> [--seed N] [--output FILE | --data-dir DIR]" << std::endl;
+    return -2;
+  }
+  int day;
+  uint64_t scale;
+  try {
+    day = std::stoi(args[0]);
+    scale = std::stoull(args[1]);
+  } catch (...) {
+    std::cerr << "ERROR: Invalid parameter!" << std::endl;
+    return -2;
+  }
+  auto generator = aoc::find_input_generator(day);
+  if (generator == nullptr) {
+    std::cerr << "ERROR: No generator for day " << day << " (see --list)" << std::endl;
+    return -3;
+  }
+  if (scale < 1) {
+    std::cerr << "ERROR: Scale must be at least 1" << std::endl;
+    return -3;
+  }
+
+  aoc::generator_rng_t rng(seed);
+  if (output_filepath.empty() && data_dirpath.empty()) {
+    generator->_generate(std::cout, scale, rng);
+    return 0;
+  }
+
+  if (!data_dirpath.empty()) {
+    auto day_dirpath = std::filesystem::path(data_dirpath) / ("day" + std::to_string(day));
+    std::error_code error;
+    std::filesystem::create_directories(day_dirpath / "problem1", error);
+    std::filesystem::create_directories(day_dirpath / "problem2", error);
+    output_filepath = (day_dirpath / "problem1" / "input.txt").string();
+  }
+  {
+    std::ofstream out(output_filepath, std::ios::binary | std::ios::trunc);
+    if (out) generator->_generate(out, scale, rng);
+    if (!out) {
+      std::cerr << "ERROR: Could not write " << output_filepath << std::endl;
+      return -4;
+    }
+  }
+  if (!data_dirpath.empty()) {
+    auto day_dirpath = std::filesystem::path(data_dirpath) / ("day" + std::to_string(day));
+    std::error_code error;
+    std::filesystem::copy_file(output_filepath, day_dirpath / "problem2" / "input.txt",
+                               std::filesystem::copy_options::overwrite_existing, error);
+    if (error) {
+      std::cerr << "ERROR: Could not write " << (day_dirpath / "problem2" / "input.txt").string() << std::endl;
+      return -4;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include "input_generator.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+namespace aoc {
+
+  namespace {
+
+    uint64_t random_between(generator_rng_t &rng, uint64_t min, uint64_t max) {
+      return std::uniform_int_distribution<uint64_t>(min, max)(rng);
+    }
+
+    // Fixed width name for index; the first character comes from first_alphabet, the others from alphabet
+    std::string make_name(uint64_t index, size_t width, const std::string &first_alphabet, const std::string &alphabet) {
+      std::string name(width, ' ');
+      for (size_t i = width - 1; i > 0; i--) {
+        name[i] = alphabet[index % alphabet.size()];
+        index /= alphabet.size();
+      }
+      name[0] = first_alphabet[index % first_alphabet.size()];
+      return name;
+    }
+
+    size_t get_name_width(uint64_t count, size_t min_width, uint64_t first_alphabet_size, uint64_t alphabet_size) {
+      size_t width = 1;
+      uint64_t capacity = first_alphabet_size;
+      while (capacity < count || width < min_width) {
+        width++;
+        capacity *= alphabet_size;
+      }
+      return width;
+    }
+
+    // scale: number of module masses
+    void generate_day1(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      for (uint64_t i = 0; i < scale; i++) {
+        out << random_between(rng, 50000, 150000) << '\n';
+      }
+    }
+
+    // scale: number of segments per wire. The first two segments of each wire guarantee a crossing at (10, 5).
+    void generate_day3(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      const char *directions = "RULD";
+      const char *wire_starts[2] = {"R10,U10", "U5,R20"};
+      for (auto wire_start : wire_starts) {
+        std::string line = wire_start;
+        for (uint64_t i = 2; i < scale; i++) {
+          line.push_back(',');
+          line.push_back(directions[random_between(rng, 0, 3)]);
+          line.append(std::to_string(random_between(rng, 1, 1000)));
+        }
+        out << line << '\n';
+      }
+    }
+
+    // scale: number of objects orbiting COM (directly or indirectly). Each object orbits one of the 16 objects created
+    // just before it, which keeps the tree deep like the real inputs. YOU and SAN orbit random objects. Lines are
+    // shuffled.
+    void generate_day6(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      // Names start with a digit so they never clash with COM, YOU or SAN
+      const std::string digits = "0123456789", alphabet = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+      auto width = get_name_width(scale, 3, digits.size(), alphabet.size());
+      auto get_name = [&](uint64_t index) -> std::string {
+        return index == 0 ? "COM" : make_name(index - 1, width, digits, alphabet);
+      };
+
+      // parents[i] is the parent of object i + 1 (object 0 is COM)
+      std::vector<uint64_t> parents(scale);
+      for (uint64_t i = 0; i < scale; i++) {
+        auto object = i + 1;
+        parents[i] = object - random_between(rng, 1, std::min<uint64_t>(object, 16));
+      }
+      std::vector<uint64_t> order(scale + 2);
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), rng);
+      for (auto line_idx : order) {
+        if (line_idx == scale) {
+          out << get_name(random_between(rng, 0, scale)) << ")YOU\n";
+        } else if (line_idx == scale + 1) {
+          out << get_name(random_between(rng, 0, scale)) << ")SAN\n";
+        } else {
+          out << get_name(parents[line_idx]) << ')' << get_name(line_idx + 1) << '\n';
+        }
+      }
+    }
+
+    // scale: number of 25x6 layers of 0/1/2 pixels
+    void generate_day8(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      std::string layer(25 * 6, '0');
+      for (uint64_t i = 0; i < scale; i++) {
+        for (auto &pixel : layer) pixel = char('0' + random_between(rng, 0, 2));
+        out << layer;
+      }
+      out << '\n';
+    }
+
+    // scale: width and height of the asteroid map (about a third of the cells are asteroids)
+    void generate_day10(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      std::string row(scale, '.');
+      for (uint64_t y = 0; y < scale; y++) {
+        for (auto &cell : row) cell = random_between(rng, 0, 2) == 0 ? '#' : '.';
+        out << row << '\n';
+      }
+    }
+
+    // scale: number of moons
+    void generate_day12(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      auto coordinate = [&]() { return int64_t(random_between(rng, 0, 40)) - 20; };
+      for (uint64_t i = 0; i < scale; i++) {
+        out << "<x=" << coordinate() << ", y=" << coordinate() << ", z=" << coordinate() << ">\n";
+      }
+    }
+
+    // scale: number of intermediate chemicals. Chemicals are created in order; each reaction consumes one chemical
+    // nobody has consumed yet plus up to two earlier ones (or ORE), so every chemical is reachable from FUEL, which
+    // consumes whatever is left over.
+    void generate_day14(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      // Names never start with O or F, so they cannot clash with ORE or FUEL
+      const std::string first_letters = "ABCDEGHIJKLMNPQRSTUVWXYZ", letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+      auto width = get_name_width(scale, 2, first_letters.size(), letters.size());
+      auto get_name = [&](uint64_t index) { return make_name(index, width, first_letters, letters); };
+      auto write_input = [&](std::string &line, const std::string &chemical) {
+        if (!line.empty()) line.append(", ");
+        line.append(std::to_string(random_between(rng, 1, 10))).append(" ").append(chemical);
+      };
+
+      const uint64_t num_base_chemicals = std::min<uint64_t>(scale, 5);
+      std::vector<uint64_t> unconsumed;
+      for (uint64_t chemical = 0; chemical < scale; chemical++) {
+        std::string line;
+        if (chemical < num_base_chemicals) {
+          write_input(line, "ORE");
+        } else {
+          auto unconsumed_idx = random_between(rng, 0, unconsumed.size() - 1);
+          auto consumed = unconsumed[unconsumed_idx];
+          unconsumed[unconsumed_idx] = unconsumed.back();
+          unconsumed.pop_back();
+          write_input(line, get_name(consumed));
+          // Index `chemical` stands for ORE
+          std::vector<uint64_t> inputs = {consumed};
+          auto num_extra_inputs = random_between(rng, 0, 2);
+          for (uint64_t i = 0; i < num_extra_inputs; i++) {
+            auto input = random_between(rng, 0, chemical);
+            if (std::find(inputs.begin(), inputs.end(), input) != inputs.end()) continue;
+            inputs.push_back(input);
+            write_input(line, input == chemical ? "ORE" : get_name(input));
+          }
+        }
+        unconsumed.push_back(chemical);
+        out << line << " => " << random_between(rng, 1, 10) << ' ' << get_name(chemical) << '\n';
+      }
+
+      std::string line;
+      for (auto chemical : unconsumed) write_input(line, get_name(chemical));
+      if (line.empty()) write_input(line, "ORE");
+      out << line << " => 1 FUEL\n";
+    }
+
+    // scale: number of digits
+    void generate_day16(std::ostream &out, uint64_t scale, generator_rng_t &rng) {
+      std::string digits(4096, '0');
+      for (uint64_t written = 0; written < scale; written += digits.size()) {
+        auto count = std::min<uint64_t>(digits.size(), scale - written);
+        for (uint64_t i = 0; i < count; i++) digits[i] = char('0' + random_between(rng, 0, 9));
+        out.write(digits.data(), count);
+      }
+      out << '\n';
+    }
+
+  } // namespace
+
+  const std::vector<input_generator_t> &get_input_generators() {
+    static const std::vector<input_generator_t> generators = {
+        {1, "module masses", 100, generate_day1},
+        {3, "segments per wire", 300, generate_day3},
+        {6, "orbiting objects", 1000, generate_day6},
+        {8, "25x6 layers", 100, generate_day8},
+        {10, "map width/height", 21, generate_day10},
+        {12, "moons", 4, generate_day12},
+        {14, "chemicals", 60, generate_day14},
+        {16, "digits", 650, generate_day16},
+    };
+    return generators;
+  }
+
+  const input_generator_t *find_input_generator(int day) {
+    for (auto &generator : get_input_generators()) {
+      if (generator._day == day) return &generator;
+    }
+    return nullptr;
+  }
+
+} // namespace aoc
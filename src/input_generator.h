@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace aoc {
+
+  using generator_rng_t = std::mt19937_64;
+
+  // Writes a valid puzzle input for one day. `scale` is the day's natural size unit (see _scale_unit).
+  using generator_fn_t = void (*)(std::ostream &out, uint64_t scale, generator_rng_t &rng);
+
+  struct input_generator_t {
+    int _day;
+    const char *_scale_unit;
+    uint64_t _puzzle_scale; // Roughly the size of the real puzzle input, for reference
+    generator_fn_t _generate;
+  };
+
+  // Generators for the days whose input is data rather than a program. IntCode days are not covered, since their
+  // inputs are puzzle-specific programs, and neither are day4 (no input file) and the unimplemented days.
+  const std::vector<input_generator_t> &get_input_generators();
+  const input_generator_t *find_input_generator(int day);
+
+} // namespace aoc
@@ -0,0 +1,112 @@
+#include "input_registry.h"
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+namespace aoc {
+
+  namespace {
+
+    const std::string_view DATA_PREFIX = "data/";
+
+    thread_local scoped_input_override_t *current_override = nullptr;
+
+  } // namespace
+
+  void input_registry_t::set_data_root(std::string data_root) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _data_root = std::move(data_root);
+  }
+
+  std::string input_registry_t::resolve_path(const char *filepath) {
+    std::string_view path(filepath);
+    if (current_override != nullptr && path.substr(0, DATA_PREFIX.size()) == DATA_PREFIX) {
+      current_override->_consumed = true;
+      return current_override->_filepath;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_data_root.empty() || path.substr(0, DATA_PREFIX.size()) != DATA_PREFIX) return std::string(path);
+    return _data_root + "/" + std::string(path.substr(DATA_PREFIX.size()));
+  }
+
+  void input_registry_t::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _parsed.clear();
+    _inputs_by_hash.clear();
+    _inputs_by_path.clear();
+    _inputs.clear();
+  }
+
+  void input_registry_t::release(const std::string &filepath) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto path_iter = _inputs_by_path.find(filepath);
+    if (path_iter == _inputs_by_path.end()) return;
+    auto input = path_iter->second;
+    _inputs_by_path.erase(path_iter);
+    for (auto &[other_filepath, other_input] : _inputs_by_path) {
+      if (other_input == input) return;
+    }
+
+    for (auto parsed_iter = _parsed.begin(); parsed_iter != _parsed.end();) {
+      if (parsed_iter->first.first == input) parsed_iter = _parsed.erase(parsed_iter);
+      else parsed_iter++;
+    }
+    auto [begin, end] = _inputs_by_hash.equal_range(input->_hash);
+    for (auto hash_iter = begin; hash_iter != end; hash_iter++) {
+      if (hash_iter->second == input) {
+        _inputs_by_hash.erase(hash_iter);
+        break;
+      }
+    }
+    _inputs.erase(std::find_if(_inputs.begin(), _inputs.end(), [input](const auto &owned_input) {
+      return owned_input.get() == input;
+    }));
+  }
+
+  const input_t *input_registry_t::find_or_load(const char *unresolved_filepath) {
+    auto resolved_filepath = resolve_path(unresolved_filepath);
+    auto filepath = resolved_filepath.c_str();
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto path_iter = _inputs_by_path.find(filepath);
+    if (path_iter != _inputs_by_path.end()) return path_iter->second;
+
+    mapped_file_t file(filepath);
+    if (!file.is_valid()) return nullptr;
+    auto hash = std::hash<std::string_view>{}(file.view());
+
+    // Same contents under another path: share the existing mapping and drop this one
+    auto [begin, end] = _inputs_by_hash.equal_range(hash);
+    for (auto hash_iter = begin; hash_iter != end; hash_iter++) {
+      if (hash_iter->second->text() == file.view()) {
+        _num_deduplicated++;
+        _inputs_by_path.emplace(filepath, hash_iter->second);
+        return hash_iter->second;
+      }
+    }
+
+    auto input = std::make_unique<input_t>();
+    input->_file = std::move(file);
+    input->_hash = hash;
+    const input_t *result = input.get();
+    _inputs.push_back(std::move(input));
+    _inputs_by_path.emplace(filepath, result);
+    _inputs_by_hash.emplace(hash, result);
+    return result;
+  }
+
+  input_registry_t &get_input_registry() {
+    static input_registry_t registry;
+    return registry;
+  }
+
+  scoped_input_override_t::scoped_input_override_t(std::string filepath)
+      : _filepath(std::move(filepath)), _previous(current_override) {
+    current_override = this;
+  }
+
+  scoped_input_override_t::~scoped_input_override_t() {
+    current_override = _previous;
+  }
+
+} // namespace aoc
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace aoc {
+
+  // An input file's contents. Files with identical contents share one input_t.
+  struct input_t {
+    mapped_file_t _file;
+    size_t _hash = 0;
+
+    std::string_view text() const { return _file.view(); }
+  };
+
+  // Process-wide registry of puzzle inputs. Each file is mapped once, identical contents (e.g. the problem1 and
+  // problem2 copies of a day's input) are deduplicated by hash, and parsed representations are cached per content
+  // so every input is read and parsed at most once per run. Safe to use from multiple threads.
+  struct input_registry_t {
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<input_t>> _inputs;
+    std::unordered_map<std::string, const input_t *> _inputs_by_path;
+    std::unordered_multimap<size_t, const input_t *> _inputs_by_hash;
+    std::map<std::pair<const input_t *, std::type_index>, std::shared_ptr<const void>> _parsed;
+    size_t _num_deduplicated = 0;
+    std::string _data_root;
+
+    // Solvers name their inputs "data/day<N>/...". With a data root set, that prefix is replaced by the root, so the
+    // same solvers can run on inputs elsewhere (e.g. generated ones). An empty root restores data/.
+    void set_data_root(std::string data_root);
+    std::string resolve_path(const char *filepath);
+
+    // Drops every mapped input and parsed object. Only safe while no solver is running.
+    void clear();
+
+    // Forgets the resolved path filepath, and drops its mapping and parsed objects unless another path shares the
+    // same contents. Only safe once nothing uses what was loaded through filepath. Batch mode calls this after each
+    // run so memory does not grow with the number of inputs.
+    void release(const std::string &filepath);
+
+    // Returns nullptr if filepath cannot be mapped. filepath is resolved against the data root.
+    const input_t *find_or_load(const char *filepath);
+
+    // Returns the parsed_t for filepath's contents, calling parser(text, parsed_t &) -> bool the first time that
+    // content is requested as a parsed_t. Returns nullptr if the file cannot be mapped or the parser fails.
+    template<typename parsed_t, typename parser_t>
+    const parsed_t *get_parsed(const char *filepath, parser_t parser) {
+      auto input = find_or_load(filepath);
+      if (input == nullptr) return nullptr;
+      std::pair<const input_t *, std::type_index> key{input, std::type_index(typeid(parsed_t))};
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto parsed_iter = _parsed.find(key);
+        if (parsed_iter != _parsed.end()) return static_cast<const parsed_t *>(parsed_iter->second.get());
+      }
+      // Parse outside the lock so unrelated inputs can be parsed concurrently
+      auto parsed = std::make_shared<parsed_t>();
+      if (!parser(input->text(), *parsed)) return nullptr;
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto [parsed_iter, inserted] = _parsed.emplace(key, std::move(parsed));
+      return static_cast<const parsed_t *>(parsed_iter->second.get());
+    }
+  };
+
+  input_registry_t &get_input_registry();
+
+  // While alive, every "data/..." path this thread resolves maps to filepath instead, so a solver can run on an
+  // arbitrary input file (batch mode). Takes precedence over the data root. Overrides nest. _consumed tells whether the
+  // solver actually resolved an input through it; solvers with built-in inputs never do.
+  struct scoped_input_override_t {
+    std::string _filepath;
+    bool _consumed = false;
+    scoped_input_override_t *_previous;
+
+    explicit scoped_input_override_t(std::string filepath);
+    ~scoped_input_override_t();
+
+    scoped_input_override_t(const scoped_input_override_t &) = delete;
+    scoped_input_override_t &operator=(const scoped_input_override_t &) = delete;
+  };
+
+} // namespace aoc
@@ -0,0 +1,134 @@
+#include "intcode_image.h"
+
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace aoc::intcode_image {
+
+  static_assert(std::endian::native == std::endian::little, "IntCode images store little-endian cells");
+
+  namespace {
+
+    struct source_stamp_t {
+      uint64_t _size = 0;
+      int64_t _mtime_ns = 0;
+    };
+
+    bool get_source_stamp(const char *text_filepath, source_stamp_t &outstamp) {
+      std::error_code error;
+      auto size = std::filesystem::file_size(text_filepath, error);
+      if (error) return false;
+      auto mtime = std::filesystem::last_write_time(text_filepath, error);
+      if (error) return false;
+      outstamp._size = size;
+      outstamp._mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+      return true;
+    }
+
+    bool is_current(const image_t &image, const source_stamp_t &stamp) {
+      if (!image.is_valid()) return false;
+      auto &header = image.header();
+      return std::memcmp(header._magic, MAGIC, sizeof(MAGIC)) == 0 &&
+             header._version == VERSION &&
+             header._source_size == stamp._size &&
+             header._source_mtime_ns == stamp._mtime_ns &&
+             image._file._size == sizeof(header_t) + header._num_cells * sizeof(int64_t) &&
+             hash_cells(image.cells(), header._num_cells) == header._program_hash;
+    }
+
+  } // namespace
+
+  uint64_t hash_cells(const int64_t *cells, size_t num_cells) {
+    // FNV-1a over the cell bytes
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto bytes = reinterpret_cast<const unsigned char *>(cells);
+    for (size_t i = 0; i < num_cells * sizeof(int64_t); i++) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  bool parse_text(std::string_view text, std::vector<int64_t> &outcells) {
+    const char *cursor = text.data();
+    const char *end = text.data() + text.size();
+    outcells.reserve(outcells.size() + text.size() / 2);
+    while (cursor < end) {
+      if (*cursor == ',' || *cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t') {
+        cursor++;
+        continue;
+      }
+      int64_t value = 0;
+      auto [next, error] = std::from_chars(cursor, end, value);
+      if (error != std::errc()) return false;
+      outcells.push_back(value);
+      cursor = next;
+    }
+    return true;
+  }
+
+  bool convert(const char *text_filepath, const char *image_filepath) {
+    source_stamp_t stamp;
+    if (!get_source_stamp(text_filepath, stamp)) return false;
+    mapped_file_t text(text_filepath);
+    std::vector<int64_t> cells;
+    if (!text.is_valid() || !parse_text(text.view(), cells)) return false;
+
+    header_t header{};
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._source_size = stamp._size;
+    header._source_mtime_ns = stamp._mtime_ns;
+    header._num_cells = cells.size();
+    header._program_hash = hash_cells(cells.data(), cells.size());
+
+    // Write to a temporary file and rename it into place so concurrent readers never see a partial image
+    static std::atomic<unsigned> temp_counter{0};
+    std::string temp_filepath = std::string(image_filepath) + ".tmp." + std::to_string(::getpid()) + "." +
+                                std::to_string(temp_counter++);
+    {
+      std::ofstream output_stream(temp_filepath, std::ios::binary | std::ios::trunc);
+      output_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      output_stream.write(reinterpret_cast<const char *>(cells.data()), cells.size() * sizeof(int64_t));
+      if (!output_stream.good()) {
+        std::remove(temp_filepath.c_str());
+        return false;
+      }
+    }
+    if (std::rename(temp_filepath.c_str(), image_filepath) != 0) {
+      std::remove(temp_filepath.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  image_t load_image(const char *text_filepath) {
+    source_stamp_t stamp;
+    if (!get_source_stamp(text_filepath, stamp)) return {};
+    std::string image_filepath = std::string(text_filepath) + EXTENSION;
+
+    image_t image{mapped_file_t(image_filepath.c_str())};
+    if (is_current(image, stamp)) return image;
+
+    if (!convert(text_filepath, image_filepath.c_str())) return {};
+    image = image_t{mapped_file_t(image_filepath.c_str())};
+    if (is_current(image, stamp)) return image;
+    return {};
+  }
+
+  bool load_cells(const char *text_filepath, std::string_view text, std::vector<int64_t> &outcells) {
+    // The cache lives next to the file the text actually came from
+    auto image = load_image(get_input_registry().resolve_path(text_filepath).c_str());
+    if (!image.is_valid()) return parse_text(text, outcells);
+    outcells.assign(image.cells(), image.cells() + image.num_cells());
+    return true;
+  }
+
+} // namespace aoc::intcode_image
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "input_registry.h"
+#include "mapped_file.h"
+
+namespace aoc::intcode_image {
+
+  /*
+    Precompiled IntCode program image
+
+      header_t
+      int64_t cells[_num_cells]   (little-endian)
+
+    The image for "input.txt" is cached next to it as "input.txt.ici". It is rebuilt whenever the size or
+    modification time of the text file no longer matches the header.
+   */
+  constexpr char MAGIC[4] = {'I', 'C', 'I', 'M'};
+  constexpr uint32_t VERSION = 1;
+  constexpr const char *EXTENSION = ".ici";
+
+  struct header_t {
+    char _magic[4];
+    uint32_t _version;
+    uint64_t _source_size;
+    int64_t _source_mtime_ns;
+    uint64_t _num_cells;
+    uint64_t _program_hash;
+  };
+
+  // Mapped image; cells() points straight into the mapping
+  struct image_t {
+    mapped_file_t _file;
+
+    bool is_valid() const { return _file.is_valid() && _file._size >= sizeof(header_t); }
+    const header_t &header() const { return *reinterpret_cast<const header_t *>(_file._data); }
+    const int64_t *cells() const { return reinterpret_cast<const int64_t *>(_file._data + sizeof(header_t)); }
+    size_t num_cells() const { return header()._num_cells; }
+  };
+
+  uint64_t hash_cells(const int64_t *cells, size_t num_cells);
+
+  // Parses comma separated IntCode text. Returns false on malformed input.
+  bool parse_text(std::string_view text, std::vector<int64_t> &outcells);
+
+  // Converts an IntCode text file into a binary image
+  bool convert(const char *text_filepath, const char *image_filepath);
+
+  // Maps the cached image for text_filepath, (re)building the cache first if it is missing or stale. The returned
+  // image is invalid if the text could not be parsed or the cache could not be written.
+  image_t load_image(const char *text_filepath);
+
+  // Reads the cells of text_filepath (whose contents are text) from its binary image, or parses text if no usable
+  // image can be built (e.g. read-only data directory)
+  bool load_cells(const char *text_filepath, std::string_view text, std::vector<int64_t> &outcells);
+
+  // Appends the program in text_filepath to outdata. The cells are loaded once per distinct input through the
+  // input registry, going through the binary image cache when possible.
+  template<typename unit_t>
+  bool load(std::vector<unit_t> &outdata, const char *text_filepath) {
+    static_assert(sizeof(unit_t) == sizeof(int64_t));
+    auto cells = get_input_registry().get_parsed<std::vector<int64_t>>(
+        text_filepath,
+        [text_filepath](std::string_view text, std::vector<int64_t> &outcells) {
+          return load_cells(text_filepath, text, outcells);
+        }
+    );
+    if (cells == nullptr) return false;
+    auto offset = outdata.size();
+    outdata.resize(offset + cells->size());
+    std::memcpy(outdata.data() + offset, cells->data(), cells->size() * sizeof(int64_t));
+    return true;
+  }
+
+} // namespace aoc::intcode_image
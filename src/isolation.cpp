@@ -0,0 +1,134 @@
+#include "isolation.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace aoc {
+
+  namespace {
+
+    // Child exit statuses besides 0
+    constexpr int EXIT_OutOfMemory = 3;
+    constexpr int EXIT_Exception = 4;
+    constexpr int EXIT_SetupFailed = 5;
+
+    bool apply_limits(const isolation_limits_t &limits) {
+      if (limits._cpu_seconds > 0) {
+        rlimit cpu_limit{};
+        cpu_limit.rlim_cur = limits._cpu_seconds;
+        cpu_limit.rlim_max = limits._cpu_seconds + 1;
+        if (setrlimit(RLIMIT_CPU, &cpu_limit) != 0) return false;
+      }
+      if (limits._memory_mb > 0) {
+        rlimit memory_limit{};
+        memory_limit.rlim_cur = memory_limit.rlim_max = limits._memory_mb * 1024 * 1024;
+        if (setrlimit(RLIMIT_AS, &memory_limit) != 0) return false;
+      }
+      return true;
+    }
+
+    std::string describe_failure(int status, const isolation_limits_t &limits) {
+      if (WIFSIGNALED(status)) {
+        auto signal = WTERMSIG(status);
+        if (limits._cpu_seconds > 0 && (signal == SIGXCPU || signal == SIGKILL)) {
+          return "CPU time limit of " + std::to_string(limits._cpu_seconds) + " s exceeded";
+        }
+        return std::string("killed by signal ") + std::to_string(signal) + " (" + strsignal(signal) + ")";
+      }
+      switch (WEXITSTATUS(status)) {
+        case EXIT_OutOfMemory:
+          return limits._memory_mb > 0 ? "out of memory (limit " + std::to_string(limits._memory_mb) + " MB)" : "out of memory";
+        case EXIT_Exception:
+          return "uncaught exception";
+        case EXIT_SetupFailed:
+          return "could not apply resource limits";
+        default:
+          return "exited with status " + std::to_string(WEXITSTATUS(status));
+      }
+    }
+
+    double to_ms(const timeval &time) {
+      return time.tv_sec * 1000.0 + time.tv_usec / 1000.0;
+    }
+
+  } // namespace
+
+  isolated_result_t run_isolated(
+      const problem_t &problem,
+      const isolation_limits_t &limits,
+      const std::function<void(const problem_t &)> &run_one
+  ) {
+    isolated_result_t result;
+    result._day = problem._day;
+    result._problem = problem._problem;
+
+    // Anything still buffered would otherwise be written by both processes
+    std::cout.flush();
+    std::cerr.flush();
+
+    auto start = std::chrono::steady_clock::now();
+    auto pid = fork();
+    if (pid < 0) {
+      result._failure = std::string("fork failed: ") + strerror(errno);
+      return result;
+    }
+
+    if (pid == 0) {
+      // Line buffered even into a pipe, so a child killed mid-problem loses at most a partial line
+      setvbuf(stdout, nullptr, _IOLBF, 0);
+      int exit_status = 0;
+      if (!apply_limits(limits)) {
+        exit_status = EXIT_SetupFailed;
+      } else {
+        try {
+          run_one(problem);
+        } catch (const std::bad_alloc &) {
+          exit_status = EXIT_OutOfMemory;
+        } catch (...) {
+          exit_status = EXIT_Exception;
+        }
+      }
+      std::cout.flush();
+      // Skip static destructors and atexit handlers, they belong to the parent
+      _exit(exit_status);
+    }
+
+    int status = 0;
+    rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0) {
+      if (errno != EINTR) {
+        result._failure = std::string("wait4 failed: ") + strerror(errno);
+        return result;
+      }
+    }
+    result._wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result._user_ms = to_ms(usage.ru_utime);
+    result._system_ms = to_ms(usage.ru_stime);
+    result._max_rss_kb = usage.ru_maxrss;
+    result._minor_faults = usage.ru_minflt;
+    result._major_faults = usage.ru_majflt;
+    result._voluntary_switches = usage.ru_nvcsw;
+    result._involuntary_switches = usage.ru_nivcsw;
+    result._ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!result._ok) result._failure = describe_failure(status, limits);
+    return result;
+  }
+
+  void print_isolated_result(std::ostream &out, const isolated_result_t &result) {
+    if (!result._ok) {
+      out << "FAILED: Day " << result._day << " - Problem " << result._problem << ": " << result._failure << std::endl;
+    }
+    out << "  isolated: wall " << result._wall_ms << " ms  user " << result._user_ms << " ms  sys " << result._system_ms
+        << " ms  max rss " << result._max_rss_kb << " KB  faults " << result._minor_faults << " minor / "
+        << result._major_faults << " major  ctx switches " << result._voluntary_switches << " voluntary / "
+        << result._involuntary_switches << " involuntary\n" << std::endl;
+  }
+
+} // namespace aoc
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "scheduler.h"
+
+namespace aoc {
+
+  // Resource limits applied to the child process of an isolated problem. 0 means unlimited.
+  struct isolation_limits_t {
+    int _cpu_seconds = 0;      // RLIMIT_CPU: SIGXCPU at the limit, SIGKILL one second later
+    uint64_t _memory_mb = 0;   // RLIMIT_AS: allocations beyond it fail with std::bad_alloc
+  };
+
+  struct isolated_result_t {
+    int _day = 0;
+    int _problem = 0;
+    bool _ok = false;
+    std::string _failure;   // Why the child did not exit cleanly
+    double _wall_ms = 0;
+    double _user_ms = 0;
+    double _system_ms = 0;
+    long _max_rss_kb = 0;
+    long _minor_faults = 0;
+    long _major_faults = 0;
+    long _voluntary_switches = 0;
+    long _involuntary_switches = 0;
+  };
+
+  // Runs run_one(problem) in a forked child under the given limits and collects the child's resource usage with
+  // wait4. A crashing, runaway or memory hungry solver only takes down its own child; the parent reports the failure
+  // and carries on. The child writes to the inherited std::cout; state it changes (caches, span buffers, recorded
+  // results) does not reach the parent.
+  isolated_result_t run_isolated(
+      const problem_t &problem,
+      const isolation_limits_t &limits,
+      const std::function<void(const problem_t &)> &run_one
+  );
+
+  void print_isolated_result(std::ostream &out, const isolated_result_t &result);
+
+} // namespace aoc
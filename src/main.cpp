@@ -1,6 +1,24 @@
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <vector>
 #include <functional>
+#include <optional>
+#include <string>
+
+#include "alloc_stats.h"
+#include "batch.h"
+#include "benchmark.h"
+#include "cpu_control.h"
+#include "isolation.h"
+#include "output_sink.h"
+#include "perf_counters.h"
+#include "regression.h"
+#include "sampling_profiler.h"
+#include "scaling.h"
+#include "shard.h"
+#include "trace_spans.h"
+#include "scheduler.h"
 
 #define DECLARE_DAY(n) \
   namespace day##n { \
@@ -33,10 +51,225 @@ DECLARE_DAY(21);
 DECLARE_DAY(22);
 DECLARE_DAY(23);
 
-void run_problem(int day, int problem, const std::function<void(void)>& logic) {
-  std::cout << "Day " << day << " - Problem " << problem << std::endl;
+// Durations of the last parallel run, used to start the longest problems first
+const char *DURATION_HISTORY_FILEPATH = ".aoc_durations";
+
+struct harness_options_t {
+  bool _quiet = false;
+  bool _counters = false;
+  bool _allocs = false;
+  std::string _trace_filepath;
+  std::string _profile_dir;
+  int _profile_hz = 997;
+  aoc::shard_t _shard;
+  std::string _shard_filepath;
+  bool _merge_shards = false;
+  bool _isolate = false;
+  aoc::isolation_limits_t _isolation_limits;
+  aoc::batch_options_t _batch_options;
+  aoc::cpu_options_t _cpu_options;
+  bool _bench = false;
+  aoc::bench_options_t _bench_options;
+  bool _check_regressions = false;
+  aoc::regression_options_t _regression_options;
+  bool _scaling = false;
+  aoc::scaling_options_t _scaling_options;
+  int _jobs = 1;
+};
+
+void run_problem(int day, int problem, const std::function<void(void)>& logic, const harness_options_t &options) {
+  // Output reaches the terminal once per problem instead of once per line. Not in an isolated child: a child killed by
+  // a signal would lose everything it printed, which is exactly the output needed to see where it failed.
+  std::optional<aoc::output_sink_t> output_sink;
+  if (!options._isolate) output_sink.emplace();
+  AOC_SPAN("Day " + std::to_string(day) + " - Problem " + std::to_string(problem));
+  aoc::out() << "Day " << day << " - Problem " << problem << std::endl;
+  std::optional<aoc::perf_counters_t> perf_counters;
+  aoc::alloc_tracker_t alloc_tracker;
+  aoc::sampling_profiler_t profiler;
+  profiler._frequency_hz = options._profile_hz;
+  bool profiling = !options._profile_dir.empty() && profiler.start();
+  if (!options._profile_dir.empty() && !profiling) std::cerr << "WARNING: Could not start the sampling profiler" << std::endl;
+  if (options._counters) perf_counters.emplace();
+  if (options._allocs) alloc_tracker.start();
+  if (perf_counters) perf_counters->start();
   logic();
-  std::cout << "..Done\n" << std::endl;
+  if (perf_counters) aoc::print_counter_report(aoc::out(), perf_counters->stop());
+  if (options._allocs) aoc::print_alloc_report(aoc::out(), alloc_tracker.stop());
+  if (profiling) {
+    auto folded_filepath = options._profile_dir + "/day" + std::to_string(day) + "_problem" + std::to_string(problem) + ".folded";
+    uint64_t num_samples = 0, num_dropped = 0;
+    if (profiler.stop(folded_filepath, num_samples, num_dropped)) {
+      aoc::out() << "  profile: " << num_samples << " samples";
+      if (num_dropped > 0) aoc::out() << " (" << num_dropped << " dropped, buffer full)";
+      aoc::out() << " -> " << folded_filepath << std::endl;
+    } else {
+      std::cerr << "ERROR: Could not write " << folded_filepath << std::endl;
+    }
+  }
+  aoc::out() << "..Done\n" << std::endl;
+}
+
+// Options (--name [value]) may appear anywhere. Everything else is a positional argument (day and problem number).
+bool parse_options(int argc, char const *argv[], harness_options_t &options, std::vector<const char *> &args) {
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+    std::string arg = argv[arg_idx];
+    if (arg.rfind("--", 0) != 0) {
+      args.push_back(argv[arg_idx]);
+      continue;
+    }
+    bool has_value = arg_idx + 1 < argc;
+    try {
+      if (arg == "--quiet") {
+        options._quiet = true;
+      } else if (arg == "--counters") {
+        options._counters = true;
+      } else if (arg == "--allocs") {
+        options._allocs = true;
+      } else if (arg == "--trace" && has_value) {
+        options._trace_filepath = argv[++arg_idx];
+      } else if (arg == "--profile" && has_value) {
+        options._profile_dir = argv[++arg_idx];
+      } else if (arg == "--profile-hz" && has_value) {
+        options._profile_hz = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--shard" && has_value) {
+        if (!aoc::parse_shard(argv[++arg_idx], options._shard)) throw std::invalid_argument(arg);
+      } else if (arg == "--shard-out" && has_value) {
+        options._shard_filepath = argv[++arg_idx];
+      } else if (arg == "--merge-shards") {
+        options._merge_shards = true;
+      } else if (arg == "--isolate") {
+        options._isolate = true;
+      } else if (arg == "--cpu-limit" && has_value) {
+        options._isolate = true;
+        options._isolation_limits._cpu_seconds = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--mem-limit" && has_value) {
+        options._isolate = true;
+        options._isolation_limits._memory_mb = std::stoull(argv[++arg_idx]);
+      } else if (arg == "--inputs" && has_value) {
+        options._batch_options._inputs_dirpath = argv[++arg_idx];
+      } else if (arg == "--csv" && has_value) {
+        options._batch_options._csv_filepath = argv[++arg_idx];
+      } else if (arg == "--pin" && has_value) {
+        if (!aoc::parse_cpu_list(argv[++arg_idx], options._cpu_options._pinned_cpus)) throw std::invalid_argument(arg);
+      } else if (arg == "--high-priority") {
+        options._cpu_options._raise_priority = true;
+      } else if (arg == "--spin-ms" && has_value) {
+        options._bench_options._spin_ms = std::stod(argv[++arg_idx]);
+      } else if (arg == "--bench") {
+        options._bench = true;
+      } else if (arg == "--warmup" && has_value) {
+        options._bench_options._warmup = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--reps" && has_value) {
+        options._bench_options._repetitions = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--warm-inputs") {
+        options._bench_options._cold_inputs = false;
+      } else if (arg == "--json" && has_value) {
+        options._bench_options._json_filepath = argv[++arg_idx];
+      } else if (arg == "--check-regressions") {
+        options._check_regressions = true;
+      } else if (arg == "--update-baseline") {
+        options._check_regressions = true;
+        options._regression_options._update = true;
+      } else if (arg == "--baseline" && has_value) {
+        options._regression_options._baseline_filepath = argv[++arg_idx];
+      } else if (arg == "--tolerance" && has_value) {
+        options._regression_options._tolerance = std::stod(argv[++arg_idx]) / 100;
+      } else if (arg == "--noise-ms" && has_value) {
+        options._regression_options._noise_floor_ms = std::stod(argv[++arg_idx]);
+      } else if (arg == "--scaling") {
+        options._scaling = true;
+      } else if (arg == "--replicate") {
+        options._scaling_options._replicate = true;
+      } else if (arg == "--scaling-steps" && has_value) {
+        options._scaling_options._steps = std::stoi(argv[++arg_idx]);
+      } else if (arg == "--scaling-factor" && has_value) {
+        options._scaling_options._factor = std::stod(argv[++arg_idx]);
+      } else if (arg == "--scaling-start" && has_value) {
+        options._scaling_options._start_size = std::stoull(argv[++arg_idx]);
+      } else if (arg == "--scaling-max-ms" && has_value) {
+        options._scaling_options._max_run_ms = std::stod(argv[++arg_idx]);
+      } else if (arg == "--jobs" && has_value) {
+        options._jobs = std::stoi(argv[++arg_idx]);
+      } else {
+        std::cerr << "ERROR: Unknown option " << arg << std::endl;
+        return false;
+      }
+    } catch (...) {
+      std::cerr << "ERROR: Invalid value for option " << arg << std::endl;
+      return false;
+    }
+  }
+  if (options._bench_options._warmup < 0 || options._bench_options._repetitions < 1) {
+    std::cerr << "ERROR: Benchmark needs --warmup >= 0 and --reps >= 1" << std::endl;
+    return false;
+  }
+  if (options._allocs && !aoc::alloc_stats_compiled_in()) {
+    std::cerr << "ERROR: --allocs needs a build configured with -DAOC_ALLOC_STATS=ON" << std::endl;
+    return false;
+  }
+  if (!options._trace_filepath.empty() && !aoc::spans_compiled_in()) {
+    std::cerr << "ERROR: --trace needs a build configured with -DAOC_SPANS=ON" << std::endl;
+    return false;
+  }
+  if (options._jobs < 1) {
+    std::cerr << "ERROR: --jobs must be at least 1" << std::endl;
+    return false;
+  }
+  if (!options._profile_dir.empty() && options._jobs > 1) {
+    std::cerr << "ERROR: --profile samples the whole process and cannot be combined with --jobs" << std::endl;
+    return false;
+  }
+  if (!options._profile_dir.empty() && (options._bench || options._check_regressions || options._scaling)) {
+    std::cerr << "ERROR: --profile only applies to normal runs" << std::endl;
+    return false;
+  }
+  if (options._shard.is_sharded() && (options._bench || options._check_regressions || options._scaling)) {
+    std::cerr << "ERROR: --shard only applies to normal runs" << std::endl;
+    return false;
+  }
+  if (options._isolate && (options._jobs > 1 || options._bench || options._check_regressions || options._scaling)) {
+    std::cerr << "ERROR: --isolate runs one problem at a time and only applies to normal runs" << std::endl;
+    return false;
+  }
+  if (options._isolate && (!options._trace_filepath.empty() || options._shard.is_sharded())) {
+    std::cerr << "ERROR: --trace and --shard collect results in the process and cannot be combined with --isolate" << std::endl;
+    return false;
+  }
+  if (!options._batch_options._inputs_dirpath.empty() &&
+      (options._bench || options._check_regressions || options._scaling || options._isolate ||
+       options._shard.is_sharded() || !options._profile_dir.empty())) {
+    std::cerr << "ERROR: --inputs is a separate mode" << std::endl;
+    return false;
+  }
+  if (options._isolation_limits._cpu_seconds < 0) {
+    std::cerr << "ERROR: --cpu-limit must not be negative" << std::endl;
+    return false;
+  }
+  if (options._shard.is_sharded() && options._shard_filepath.empty()) {
+    options._shard_filepath = "shard-" + std::to_string(options._shard._index) + "-of-" + std::to_string(options._shard._count) + ".txt";
+  }
+  if (options._profile_hz < 1 || options._profile_hz > 100000) {
+    std::cerr << "ERROR: --profile-hz must be between 1 and 100000" << std::endl;
+    return false;
+  }
+  if ((options._bench || options._check_regressions || options._scaling) && options._jobs > 1) {
+    std::cerr << "ERROR: --bench, --check-regressions and --scaling measure one problem at a time and cannot be combined with --jobs" << std::endl;
+    return false;
+  }
+  if (int(options._bench) + int(options._check_regressions) + int(options._scaling) > 1) {
+    std::cerr << "ERROR: --bench, --check-regressions and --scaling are separate modes" << std::endl;
+    return false;
+  }
+  if (options._scaling_options._steps < 2 || options._scaling_options._factor <= 1) {
+    std::cerr << "ERROR: Scaling needs --scaling-steps >= 2 and --scaling-factor > 1" << std::endl;
+    return false;
+  }
+  if (options._regression_options._tolerance < 0 || options._regression_options._noise_floor_ms < 0) {
+    std::cerr << "ERROR: --tolerance and --noise-ms must not be negative" << std::endl;
+    return false;
+  }
+  return true;
 }
 
 int main(int argc, char const *argv[]) {
@@ -66,15 +299,46 @@ int main(int argc, char const *argv[]) {
     {day23::problem1,  day23::problem2},
   };
 
-  if (argc > 3) {
+  harness_options_t options;
+  std::vector<const char *> args;
+  if (!parse_options(argc, argv, options, args)) {
+    return -6;
+  }
+  if (options._merge_shards) {
+    // Positional arguments are the partial result files of every shard
+    std::vector<std::string> shard_filepaths(args.begin(), args.end());
+    return aoc::merge_partial_results(shard_filepaths, std::cout) ? 0 : -10;
+  }
+  if (options._quiet) aoc::set_verbosity(aoc::VERBOSITY_Quiet);
+  // Before any thread exists, so every thread inherits the priority
+  if (options._cpu_options._raise_priority && !aoc::raise_priority()) {
+    std::cerr << "WARNING: Not permitted to raise the scheduling priority" << std::endl;
+  }
+  auto &pinned_cpus = options._cpu_options._pinned_cpus;
+  bool pin_workers = options._jobs > 1 || !options._batch_options._inputs_dirpath.empty();
+  if (!pinned_cpus.empty() && !pin_workers && !aoc::pin_current_thread(pinned_cpus.front())) {
+    std::cerr << "WARNING: Could not pin to CPU " << pinned_cpus.front() << std::endl;
+  }
+  aoc::set_shard(options._shard);
+  if (!options._trace_filepath.empty()) aoc::start_span_trace();
+  if (!options._profile_dir.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(options._profile_dir, error);
+    if (error) {
+      std::cerr << "ERROR: Could not create " << options._profile_dir << std::endl;
+      return -6;
+    }
+  }
+
+  if (args.size() > 2) {
     std::cerr << "ERROR: Specify no params OR a day # to run a specific day OR day and problem number" << std::endl;
     return -1;
   }
 
   int day_to_run = -1;
-  if (argc >= 2) {
+  if (args.size() >= 1) {
     try {
-      day_to_run = std::stoi(argv[1]);
+      day_to_run = std::stoi(args[0]);
     } catch (...) {
       std::cerr << "ERROR: Invalid parameter!" << std::endl;
       return -2;
@@ -86,9 +350,9 @@ int main(int argc, char const *argv[]) {
   }
 
   int problem_to_run = -1;
-  if (argc == 3 && day_to_run != -1) {
+  if (args.size() == 2 && day_to_run != -1) {
     try {
-      problem_to_run = std::stoi(argv[2]);
+      problem_to_run = std::stoi(args[1]);
     } catch (...) {
       std::cerr << "ERROR: Invalid parameter!" << std::endl;
       return -4;
@@ -99,17 +363,18 @@ int main(int argc, char const *argv[]) {
     }
   }
 
+  std::vector<aoc::problem_t> problems;
   if (day_to_run != -1) {
     // Run a specific day
     auto &day_problems = days[day_to_run - 1];
     if (problem_to_run != -1) {
       std::cout << "Running ONLY day " << day_to_run << " ONLY problem " << problem_to_run << std::endl << std::endl;
-      run_problem(day_to_run, problem_to_run, day_problems[problem_to_run - 1]);
+      problems.push_back({day_to_run, problem_to_run, day_problems[problem_to_run - 1]});
     } else {
       std::cout << "Running ONLY day " << day_to_run << std::endl << std::endl;
       auto problem_num = 1;
       for (auto &problem : day_problems) {
-        run_problem(day_to_run, problem_num++, problem);
+        problems.push_back({day_to_run, problem_num++, problem});
       }
     }
   } else {
@@ -118,11 +383,106 @@ int main(int argc, char const *argv[]) {
     for (auto &day_problems : days) {
       auto problem_num = 1;
       for (auto &problem : day_problems) {
-        run_problem(day_num, problem_num++, problem);
+        problems.push_back({day_num, problem_num++, problem});
       }
       day_num++;
     }
   }
 
+  auto cpu_info = aoc::get_cpu_info(pinned_cpus);
+  if (options._bench || options._check_regressions || options._scaling) aoc::print_cpu_info(std::cout, cpu_info);
+
+  if (options._bench) {
+    std::vector<aoc::bench_result_t> bench_results;
+    for (auto &problem : problems) {
+      bench_results.push_back(aoc::run_benchmark(problem._day, problem._problem, problem._logic, options._bench_options));
+      aoc::print_bench_result(std::cout, bench_results.back());
+    }
+    if (!options._bench_options._json_filepath.empty() &&
+        !aoc::write_bench_json(options._bench_options._json_filepath, options._bench_options, cpu_info, bench_results)) {
+      std::cerr << "ERROR: Could not write " << options._bench_options._json_filepath << std::endl;
+      return -7;
+    }
+  } else if (options._check_regressions) {
+    if (problem_to_run == -1) {
+      auto &skipped_problems = options._regression_options._skipped_problems;
+      problems.erase(std::remove_if(problems.begin(), problems.end(), [&](const aoc::problem_t &problem) {
+        if (skipped_problems.count({problem._day, problem._problem}) == 0) return false;
+        std::cout << "Skipping day " << problem._day << " problem " << problem._problem << " (too slow, select it on its own to check it)" << std::endl;
+        return true;
+      }), problems.end());
+    }
+    std::vector<aoc::regression_result_t> regression_results;
+    if (!aoc::check_regressions(problems, options._bench_options, options._regression_options, regression_results)) {
+      std::cerr << "ERROR: Regression check against " << options._regression_options._baseline_filepath << " failed" << std::endl;
+      return -8;
+    }
+  } else if (options._scaling) {
+    for (auto &problem : problems) {
+      std::vector<aoc::scaling_point_t> points;
+      if (!aoc::run_scaling(problem, options._scaling_options, options._bench_options, points)) {
+        std::cerr << "ERROR: Cannot scale day " << problem._day << " problem " << problem._problem
+                  << (options._scaling_options._replicate ? " (input could not be replicated)" : " (no generator, try --replicate)") << std::endl;
+        if (points.empty()) continue;
+      }
+      aoc::print_scaling_report(std::cout, problem, points, aoc::fit_complexity(points));
+    }
+  } else if (!options._batch_options._inputs_dirpath.empty()) {
+    if (problem_to_run == -1) {
+      std::cerr << "ERROR: --inputs needs a day and a problem number" << std::endl;
+      return -1;
+    }
+    std::vector<std::string> input_filepaths;
+    if (!aoc::list_batch_inputs(options._batch_options._inputs_dirpath, input_filepaths)) {
+      std::cerr << "ERROR: Could not read " << options._batch_options._inputs_dirpath << std::endl;
+      return -12;
+    }
+    auto batch_problem = problems.front();
+    batch_problem._logic = [&]() {
+      aoc::pin_worker_thread(pinned_cpus);
+      problems.front()._logic();
+    };
+    auto batch_results = aoc::run_batch(batch_problem, input_filepaths, options._jobs);
+    for (auto &batch_result : batch_results) aoc::print_batch_result(std::cout, batch_result);
+    if (!aoc::write_batch_csv(options._batch_options._csv_filepath, problems.front(), batch_results)) {
+      std::cerr << "ERROR: Could not write " << options._batch_options._csv_filepath << std::endl;
+      return -12;
+    }
+  } else if (options._isolate) {
+    int num_failed = 0;
+    for (auto &problem : problems) {
+      auto result = aoc::run_isolated(problem, options._isolation_limits, [&](const aoc::problem_t &problem) {
+        run_problem(problem._day, problem._problem, problem._logic, options);
+      });
+      aoc::print_isolated_result(std::cout, result);
+      if (!result._ok) num_failed++;
+    }
+    if (num_failed > 0) {
+      std::cerr << "ERROR: " << num_failed << " of " << problems.size() << " isolated problems failed" << std::endl;
+      return -11;
+    }
+  } else if (options._jobs > 1) {
+    auto history = aoc::read_duration_history(DURATION_HISTORY_FILEPATH);
+    aoc::run_parallel(problems, options._jobs, history, [&](const aoc::problem_t &problem) {
+      aoc::pin_worker_thread(pinned_cpus);
+      run_problem(problem._day, problem._problem, problem._logic, options);
+    });
+    aoc::write_duration_history(DURATION_HISTORY_FILEPATH, history);
+  } else {
+    for (auto &problem : problems) {
+      run_problem(problem._day, problem._problem, problem._logic, options);
+    }
+  }
+
+  if (options._shard.is_sharded() && !aoc::write_partial_results(options._shard_filepath)) {
+    std::cerr << "ERROR: Could not write " << options._shard_filepath << std::endl;
+    return -10;
+  }
+
+  if (!options._trace_filepath.empty() && !aoc::write_span_trace(options._trace_filepath)) {
+    std::cerr << "ERROR: Could not write " << options._trace_filepath << std::endl;
+    return -9;
+  }
+
   return 0;
 }
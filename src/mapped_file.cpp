@@ -0,0 +1,59 @@
+#include "mapped_file.h"
+
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aoc {
+
+  mapped_file_t::mapped_file_t(const char *filepath) {
+    int fd = ::open(filepath, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st{};
+    if (::fstat(fd, &st) == 0) {
+      _size = static_cast<size_t>(st.st_size);
+      if (_size == 0) {
+        _valid = true;
+      } else {
+        void *addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+          ::madvise(addr, _size, MADV_SEQUENTIAL);
+          _data = static_cast<const char *>(addr);
+          _valid = true;
+        } else {
+          _size = 0;
+        }
+      }
+    }
+    ::close(fd);
+  }
+
+  mapped_file_t::~mapped_file_t() {
+    unmap();
+  }
+
+  mapped_file_t::mapped_file_t(mapped_file_t &&other) noexcept
+      : _data(std::exchange(other._data, nullptr)),
+        _size(std::exchange(other._size, 0)),
+        _valid(std::exchange(other._valid, false)) {}
+
+  mapped_file_t &mapped_file_t::operator=(mapped_file_t &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      _data = std::exchange(other._data, nullptr);
+      _size = std::exchange(other._size, 0);
+      _valid = std::exchange(other._valid, false);
+    }
+    return *this;
+  }
+
+  void mapped_file_t::unmap() {
+    if (_data != nullptr) ::munmap(const_cast<char *>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+    _valid = false;
+  }
+
+} // namespace aoc
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace aoc {
+
+  // Read-only, private memory mapping of a whole file. An empty file is valid and maps to an empty view.
+  struct mapped_file_t {
+    const char *_data = nullptr;
+    size_t _size = 0;
+    bool _valid = false;
+
+    mapped_file_t() = default;
+    explicit mapped_file_t(const char *filepath);
+    ~mapped_file_t();
+
+    mapped_file_t(const mapped_file_t &) = delete;
+    mapped_file_t &operator=(const mapped_file_t &) = delete;
+    mapped_file_t(mapped_file_t &&other) noexcept;
+    mapped_file_t &operator=(mapped_file_t &&other) noexcept;
+
+    bool is_valid() const { return _valid; }
+    std::string_view view() const { return {_data, _size}; }
+
+  private:
+    void unmap();
+  };
+
+} // namespace aoc
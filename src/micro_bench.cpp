@@ -0,0 +1,54 @@
+#include "micro_bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace aoc {
+
+  namespace {
+
+    double time_run_ms(const kernel_t &kernel, uint64_t iterations) {
+      auto start = std::chrono::steady_clock::now();
+      kernel._run(iterations);
+      clobber_memory();
+      auto end = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+  } // namespace
+
+  kernel_result_t run_kernel(const kernel_t &kernel, const micro_bench_options_t &options) {
+    kernel_result_t result;
+    result._name = kernel._name;
+    result._samples = options._samples;
+
+    uint64_t iterations = 1;
+    while (true) {
+      auto elapsed_ms = time_run_ms(kernel, iterations);
+      if (elapsed_ms >= options._min_sample_ms) break;
+      // Jump close to the target once the timing is above clock noise, otherwise keep doubling
+      auto estimate = elapsed_ms > 1 ? uint64_t(iterations * options._min_sample_ms / elapsed_ms * 1.1) : 0;
+      iterations = std::max(iterations * 2, estimate);
+    }
+    result._iterations_per_sample = iterations;
+
+    time_run_ms(kernel, iterations);
+    std::vector<double> samples;
+    for (int i = 0; i < options._samples; i++) {
+      samples.push_back(time_run_ms(kernel, iterations) * 1e6 / double(iterations));
+    }
+    result._ns_per_iteration = compute_stats(samples);
+    return result;
+  }
+
+  void print_kernel_result(std::ostream &out, const kernel_result_t &result) {
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << result._name << " (" << result._samples << " x " << result._iterations_per_sample << " iterations)" << std::endl;
+    out << "  ns/iteration  min " << result._ns_per_iteration._min << "  median " << result._ns_per_iteration._median
+        << "  p95 " << result._ns_per_iteration._p95 << "  max " << result._ns_per_iteration._max << std::endl;
+    out.flags(flags);
+  }
+
+} // namespace aoc
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace aoc {
+
+  // Keeps the compiler from discarding a value the benchmark computes but never uses
+  template<typename value_t>
+  inline void do_not_optimize(const value_t &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  // Forces pending stores to memory, so writes into a kernel's state are not elided
+  inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+  }
+
+  // A kernel runs its body `iterations` times per call. Setup belongs outside _run (captured state), so only the
+  // body is timed.
+  struct kernel_t {
+    std::string _name;
+    std::function<void(uint64_t iterations)> _run;
+  };
+
+  using kernel_registry_t = std::vector<kernel_t>;
+
+  struct micro_bench_options_t {
+    double _min_sample_ms = 20; // Each sample runs enough iterations to take at least this long
+    int _samples = 15;
+    std::string _filter;        // Only kernels whose name contains this
+  };
+
+  struct kernel_result_t {
+    std::string _name;
+    uint64_t _iterations_per_sample = 0;
+    int _samples = 0;
+    sample_stats_t _ns_per_iteration;
+  };
+
+  // Doubles the iteration count until one call takes _min_sample_ms, runs one untimed sample, then times _samples
+  // calls and reports the per iteration statistics.
+  kernel_result_t run_kernel(const kernel_t &kernel, const micro_bench_options_t &options);
+
+  void print_kernel_result(std::ostream &out, const kernel_result_t &result);
+
+} // namespace aoc
@@ -0,0 +1,40 @@
+#include "output_capture.h"
+
+#include <iostream>
+
+#include "alloc_stats.h"
+
+namespace aoc {
+
+  namespace {
+
+    thread_local std::ostream *current_stream = nullptr;
+
+  } // namespace
+
+  int capture_buffer_t::overflow(int c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    scoped_alloc_pause_t alloc_pause;
+    _output->push_back(traits_type::to_char_type(c));
+    return c;
+  }
+
+  std::streamsize capture_buffer_t::xsputn(const char *data, std::streamsize count) {
+    scoped_alloc_pause_t alloc_pause;
+    _output->append(data, count);
+    return count;
+  }
+
+  std::ostream &out() {
+    return current_stream != nullptr ? *current_stream : std::cout;
+  }
+
+  scoped_capture_t::scoped_capture_t() : _previous(current_stream) {
+    current_stream = &_stream;
+  }
+
+  scoped_capture_t::~scoped_capture_t() {
+    current_stream = _previous;
+  }
+
+} // namespace aoc
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace aoc {
+
+  // Appends everything written through it to a string. It keeps no put area, so the string is always up to date.
+  struct capture_buffer_t : std::streambuf {
+    std::string *_output;
+
+    explicit capture_buffer_t(std::string *output) : _output(output) {}
+
+  protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char *data, std::streamsize count) override;
+  };
+
+  // The stream problems write their output to: the innermost capture's stream on this thread, or std::cout when
+  // this thread has no capture. Each capture has its own std::ostream, so threads never share format state (width,
+  // precision, flags) and a problem's manipulators do not leak into the next problem.
+  std::ostream &out();
+
+  // Captures everything this thread writes to aoc::out() for the lifetime of the object. Captures nest; the
+  // innermost one receives the output.
+  struct scoped_capture_t {
+    std::string _output;
+    capture_buffer_t _buffer{&_output};
+    std::ostream _stream{&_buffer};
+    std::ostream *_previous;
+
+    scoped_capture_t();
+    ~scoped_capture_t();
+
+    scoped_capture_t(const scoped_capture_t &) = delete;
+    scoped_capture_t &operator=(const scoped_capture_t &) = delete;
+  };
+
+} // namespace aoc
@@ -0,0 +1,34 @@
+#include "output_sink.h"
+
+#include <atomic>
+#include <iostream>
+
+namespace aoc {
+
+  namespace {
+
+    std::atomic<verbosity_e> current_verbosity{VERBOSITY_Normal};
+
+  } // namespace
+
+  void set_verbosity(verbosity_e verbosity) {
+    current_verbosity = verbosity;
+  }
+
+  verbosity_e get_verbosity() {
+    return current_verbosity;
+  }
+
+  output_sink_t::output_sink_t() {
+    _capture.emplace();
+  }
+
+  output_sink_t::~output_sink_t() {
+    // Hand the buffer to whatever aoc::out() is once this capture is gone (an outer capture or std::cout)
+    auto output = std::move(_capture->_output);
+    _capture.reset();
+    out().write(output.data(), output.size());
+    out().flush();
+  }
+
+} // namespace aoc
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <optional>
+
+#include "output_capture.h"
+
+namespace aoc {
+
+  enum verbosity_e {
+    VERBOSITY_Quiet = 0,   // Only headers and results
+    VERBOSITY_Normal = 1,  // Also rendering (game boards, maps, video feeds) and progress messages
+  };
+
+  void set_verbosity(verbosity_e verbosity);
+  verbosity_e get_verbosity();
+
+  // Solvers check this before rendering or printing progress. Results are always printed.
+  inline bool show_progress() { return get_verbosity() >= VERBOSITY_Normal; }
+
+  // Buffers everything this thread writes to aoc::out() in memory and writes it out in one go when destroyed, so
+  // per-line std::endl flushes never reach the terminal. Sinks nest like scoped_capture_t.
+  struct output_sink_t {
+    std::optional<scoped_capture_t> _capture;
+
+    output_sink_t();
+    ~output_sink_t();
+
+    output_sink_t(const output_sink_t &) = delete;
+    output_sink_t &operator=(const output_sink_t &) = delete;
+  };
+
+} // namespace aoc
@@ -0,0 +1,141 @@
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace aoc {
+
+  namespace {
+
+    struct event_config_t {
+      uint32_t _type;
+      uint64_t _config;
+    };
+
+    constexpr uint64_t cache_event(uint64_t cache, uint64_t result) {
+      return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    }
+
+    // Indexed by counter_e
+    const std::array<event_config_t, COUNTER_Count> EVENT_CONFIGS = {{
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+      {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+      {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    }};
+
+    int open_counter(const event_config_t &event_config) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = event_config._type;
+      attr.config = event_config._config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      // pid 0, cpu -1: this thread on any CPU
+      return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    int64_t now_ns() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double ratio(const counter_values_t &values, counter_e numerator, counter_e denominator) {
+      return double(values.get(numerator)) / double(values.get(denominator));
+    }
+
+  } // namespace
+
+  bool counter_values_t::any() const {
+    for (auto valid : _valid) {
+      if (valid) return true;
+    }
+    return false;
+  }
+
+  perf_counters_t::perf_counters_t() {
+    for (size_t i = 0; i < COUNTER_Count; i++) _fds[i] = open_counter(EVENT_CONFIGS[i]);
+  }
+
+  perf_counters_t::~perf_counters_t() {
+    for (auto fd : _fds) {
+      if (fd >= 0) ::close(fd);
+    }
+  }
+
+  bool perf_counters_t::available() const {
+    for (auto fd : _fds) {
+      if (fd >= 0) return true;
+    }
+    return false;
+  }
+
+  void perf_counters_t::start() {
+    for (auto fd : _fds) {
+      if (fd < 0) continue;
+      ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    _start_ns = now_ns();
+  }
+
+  counter_values_t perf_counters_t::stop() {
+    counter_values_t values;
+    auto end_ns = now_ns();
+    for (auto fd : _fds) {
+      if (fd >= 0) ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    values._wall_ms = (end_ns - _start_ns) / 1e6;
+    for (size_t i = 0; i < COUNTER_Count; i++) {
+      if (_fds[i] < 0) continue;
+      // value, time enabled, time running
+      uint64_t data[3] = {};
+      if (::read(_fds[i], data, sizeof(data)) != sizeof(data)) continue;
+      if (data[2] == 0) continue; // Never got scheduled on the PMU
+      values._values[i] = data[2] < data[1] ? uint64_t(double(data[0]) * double(data[1]) / double(data[2])) : data[0];
+      values._valid[i] = true;
+    }
+    return values;
+  }
+
+  void print_counter_report(std::ostream &out, const counter_values_t &values) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3);
+    text << "  wall " << values._wall_ms << " ms";
+    if (!values.any()) {
+      text << "  (hardware counters unavailable)" << std::endl;
+      out << text.str() << std::flush;
+      return;
+    }
+    if (values.has(COUNTER_Cycles)) text << "  cycles " << values.get(COUNTER_Cycles);
+    if (values.has(COUNTER_Instructions)) text << "  instructions " << values.get(COUNTER_Instructions);
+    text << std::setprecision(2);
+    if (values.has(COUNTER_Cycles) && values.has(COUNTER_Instructions) && values.get(COUNTER_Cycles) > 0) {
+      text << "  IPC " << ratio(values, COUNTER_Instructions, COUNTER_Cycles);
+    }
+    if (values.has(COUNTER_Branches) && values.has(COUNTER_BranchMisses) && values.get(COUNTER_Branches) > 0) {
+      text << "  branch-miss " << 100 * ratio(values, COUNTER_BranchMisses, COUNTER_Branches) << "%";
+    }
+    if (values.has(COUNTER_L1dAccesses) && values.has(COUNTER_L1dMisses) && values.get(COUNTER_L1dAccesses) > 0) {
+      text << "  L1d-miss " << 100 * ratio(values, COUNTER_L1dMisses, COUNTER_L1dAccesses) << "%";
+    }
+    if (values.has(COUNTER_LlcAccesses) && values.has(COUNTER_LlcMisses) && values.get(COUNTER_LlcAccesses) > 0) {
+      text << "  LLC-miss " << 100 * ratio(values, COUNTER_LlcMisses, COUNTER_LlcAccesses) << "%";
+    }
+    text << std::endl;
+    out << text.str() << std::flush;
+  }
+
+} // namespace aoc
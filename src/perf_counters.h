@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+namespace aoc {
+
+  enum counter_e {
+    COUNTER_Cycles = 0,
+    COUNTER_Instructions,
+    COUNTER_Branches,
+    COUNTER_BranchMisses,
+    COUNTER_L1dAccesses,
+    COUNTER_L1dMisses,
+    COUNTER_LlcAccesses,
+    COUNTER_LlcMisses,
+    COUNTER_Count
+  };
+
+  struct counter_values_t {
+    std::array<uint64_t, COUNTER_Count> _values{};
+    std::array<bool, COUNTER_Count> _valid{};
+    double _wall_ms = 0;
+
+    bool has(counter_e counter) const { return _valid[counter]; }
+    uint64_t get(counter_e counter) const { return _values[counter]; }
+    bool any() const;
+  };
+
+  // Hardware counters (Linux perf_event_open) for the calling thread, user space only. Each counter is opened on its
+  // own, so a missing event only drops that counter. When the kernel refuses all of them (no PMU, perf_event_paranoid,
+  // seccomp) the counters are simply unavailable and stop() reports wall time only. Values are scaled up when the
+  // kernel had to multiplex counters.
+  struct perf_counters_t {
+    std::array<int, COUNTER_Count> _fds;
+
+    perf_counters_t();
+    ~perf_counters_t();
+
+    perf_counters_t(const perf_counters_t &) = delete;
+    perf_counters_t &operator=(const perf_counters_t &) = delete;
+
+    bool available() const;
+    void start();
+    counter_values_t stop();
+
+  private:
+    int64_t _start_ns = 0;
+  };
+
+  // One line with wall time, IPC and the branch, L1d and LLC miss rates (whatever is available)
+  void print_counter_report(std::ostream &out, const counter_values_t &values);
+
+} // namespace aoc
@@ -0,0 +1,90 @@
+#include "regression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace aoc {
+
+  verdict_e get_verdict(double baseline_ms, double median_ms, const regression_options_t &options) {
+    auto delta_ms = median_ms - baseline_ms;
+    if (std::abs(delta_ms) < options._noise_floor_ms) return VERDICT_Ok;
+    if (median_ms > baseline_ms * (1 + options._tolerance)) return VERDICT_Regressed;
+    if (median_ms < baseline_ms * (1 - options._tolerance)) return VERDICT_Faster;
+    return VERDICT_Ok;
+  }
+
+  bool check_regressions(
+      const std::vector<problem_t> &problems,
+      const bench_options_t &bench_options,
+      const regression_options_t &options,
+      std::vector<regression_result_t> &results
+  ) {
+    auto baseline = read_duration_history(options._baseline_filepath);
+    if (baseline.empty() && !options._update) {
+      // Otherwise every problem would be "new" and the check would pass without comparing anything
+      std::cerr << "ERROR: No baseline timings in " << options._baseline_filepath
+                << " (create it on a quiet machine with --update-baseline)" << std::endl;
+      return false;
+    }
+    bool ok = true;
+
+    for (auto &problem : problems) {
+      regression_result_t result;
+      result._day = problem._day;
+      result._problem = problem._problem;
+      result._median_ms = run_benchmark(problem._day, problem._problem, problem._logic, bench_options)._wall_ms._median;
+
+      auto baseline_iter = baseline.find({problem._day, problem._problem});
+      if (baseline_iter == baseline.end()) {
+        result._verdict = VERDICT_New;
+      } else {
+        result._baseline_ms = baseline_iter->second;
+        result._verdict = get_verdict(result._baseline_ms, result._median_ms, options);
+        for (int i = 0; i < options._confirm_runs && result._verdict == VERDICT_Regressed; i++) {
+          auto median_ms = run_benchmark(problem._day, problem._problem, problem._logic, bench_options)._wall_ms._median;
+          result._median_ms = std::min(result._median_ms, median_ms);
+          result._verdict = get_verdict(result._baseline_ms, result._median_ms, options);
+        }
+      }
+
+      if (result._verdict == VERDICT_Regressed) ok = false;
+      print_regression_result(std::cout, result);
+      results.push_back(result);
+    }
+
+    if (options._update) {
+      std::error_code error;
+      auto parent_path = std::filesystem::path(options._baseline_filepath).parent_path();
+      if (!parent_path.empty()) std::filesystem::create_directories(parent_path, error);
+      for (auto &result : results) baseline[{result._day, result._problem}] = result._median_ms;
+      if (!write_duration_history(options._baseline_filepath, baseline)) {
+        std::cerr << "ERROR: Could not write " << options._baseline_filepath << std::endl;
+        return false;
+      }
+      return true;
+    }
+    return ok;
+  }
+
+  void print_regression_result(std::ostream &out, const regression_result_t &result) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3);
+    text << "Day " << result._day << " - Problem " << result._problem << "  median " << result._median_ms << " ms";
+    switch (result._verdict) {
+      case VERDICT_New: text << "  (no baseline)"; break;
+      case VERDICT_Ok: text << "  baseline " << result._baseline_ms << " ms  ok"; break;
+      case VERDICT_Faster: text << "  baseline " << result._baseline_ms << " ms  FASTER"; break;
+      case VERDICT_Regressed: text << "  baseline " << result._baseline_ms << " ms  REGRESSED"; break;
+    }
+    if (result._verdict != VERDICT_New && result._baseline_ms > 0) {
+      text << std::setprecision(1) << " (" << std::showpos << 100 * (result._median_ms / result._baseline_ms - 1) << "%)";
+    }
+    text << std::endl;
+    out << text.str() << std::flush;
+  }
+
+} // namespace aoc
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "scheduler.h"
+
+namespace aoc {
+
+  struct regression_options_t {
+    std::string _baseline_filepath = "perf/baseline.txt";
+    double _tolerance = 0.10;     // Allowed relative slowdown of the median
+    double _noise_floor_ms = 1.0; // Slowdowns smaller than this are noise, whatever the ratio
+    int _confirm_runs = 2;        // Extra benchmark rounds for a problem that looks slower before calling it a regression
+    bool _update = false;         // Write the measured medians as the new baseline instead of failing
+    // Too slow to benchmark repeatedly: day16 problem 2 (also left out of AOC_PGO_TRAINING_DAYS) and day19 problem 2
+    // (about a minute per run). Only checked when selected on their own with "<day> <problem>".
+    std::set<std::pair<int, int>> _skipped_problems = {{16, 2}, {19, 2}};
+  };
+
+  enum verdict_e {
+    VERDICT_Ok = 0,
+    VERDICT_Faster,
+    VERDICT_Regressed,
+    VERDICT_New,
+  };
+
+  struct regression_result_t {
+    int _day = 0;
+    int _problem = 0;
+    double _baseline_ms = 0;
+    double _median_ms = 0;
+    verdict_e _verdict = VERDICT_Ok;
+  };
+
+  verdict_e get_verdict(double baseline_ms, double median_ms, const regression_options_t &options);
+
+  // Benchmarks every problem (median wall time over bench_options._repetitions) and compares it with the stored
+  // baseline (same "<day> <problem> <ms>" format as the duration history). A problem that looks slower is measured
+  // again up to _confirm_runs times and the fastest median is kept, so one noisy round does not fail the check.
+  // Returns false if any problem regressed, or if the baseline file is missing or empty. With _update the baseline is
+  // created or rewritten with the new medians instead. perf/baseline.txt holds the reference medians; baselines are
+  // machine specific, so on another machine rebuild it with `advent_of_code_2019 --update-baseline` (Release build,
+  // run from the repository root) before the first check.
+  bool check_regressions(
+      const std::vector<problem_t> &problems,
+      const bench_options_t &bench_options,
+      const regression_options_t &options,
+      std::vector<regression_result_t> &results
+  );
+
+  void print_regression_result(std::ostream &out, const regression_result_t &result);
+
+} // namespace aoc
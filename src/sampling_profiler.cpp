@@ -0,0 +1,140 @@
+#include "sampling_profiler.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <sys/time.h>
+#include <unordered_map>
+#include <vector>
+
+namespace aoc {
+
+  namespace {
+
+    constexpr int MAX_FRAMES = 48;
+    constexpr size_t MAX_SAMPLES = 1 << 15;
+    // The handler's own frame and the kernel's signal trampoline
+    constexpr int SKIPPED_FRAMES = 2;
+
+    struct sample_t {
+      int _num_frames;
+      void *_frames[MAX_FRAMES];
+    };
+
+    // Written by the signal handler only; slots are claimed with an atomic counter so the handler never blocks
+    std::unique_ptr<sample_t[]> samples;
+    std::atomic<size_t> num_claimed{0};
+    std::atomic<uint64_t> num_dropped{0};
+
+    void handle_sigprof(int) {
+      auto saved_errno = errno;
+      auto sample_idx = num_claimed.fetch_add(1, std::memory_order_relaxed);
+      if (sample_idx < MAX_SAMPLES) {
+        auto &sample = samples[sample_idx];
+        sample._num_frames = backtrace(sample._frames, MAX_FRAMES);
+      } else {
+        num_dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+      errno = saved_errno;
+    }
+
+    bool set_timer(int frequency_hz) {
+      itimerval timer{};
+      if (frequency_hz > 0) {
+        auto period_us = 1000000 / frequency_hz;
+        timer.it_interval.tv_sec = period_us / 1000000;
+        timer.it_interval.tv_usec = period_us % 1000000;
+        timer.it_value = timer.it_interval;
+      }
+      return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+    }
+
+    std::string symbolize(void *address) {
+      Dl_info info{};
+      if (dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+        std::free(demangled);
+        return name;
+      }
+      std::ostringstream out;
+      if (info.dli_fname != nullptr) {
+        std::string module = info.dli_fname;
+        out << module.substr(module.find_last_of('/') + 1) << "+0x" << std::hex
+            << (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+      } else {
+        out << address;
+      }
+      return out.str();
+    }
+
+  } // namespace
+
+  sampling_profiler_t::~sampling_profiler_t() {
+    if (_running) {
+      set_timer(0);
+      std::signal(SIGPROF, SIG_IGN);
+    }
+  }
+
+  bool sampling_profiler_t::start() {
+    if (_running || _frequency_hz <= 0) return false;
+    if (!samples) samples = std::make_unique<sample_t[]>(MAX_SAMPLES);
+    num_claimed = 0;
+    num_dropped = 0;
+
+    // The first backtrace() call loads libgcc, which is not safe inside a signal handler
+    void *warmup[1];
+    backtrace(warmup, 1);
+
+    struct sigaction action{};
+    action.sa_handler = handle_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) return false;
+    if (!set_timer(_frequency_hz)) return false;
+    _running = true;
+    return true;
+  }
+
+  bool sampling_profiler_t::stop(const std::string &filepath, uint64_t &outnum_samples, uint64_t &outnum_dropped) {
+    if (!_running) return false;
+    set_timer(0);
+    std::signal(SIGPROF, SIG_IGN);
+    _running = false;
+
+    auto num_samples = std::min(num_claimed.load(), MAX_SAMPLES);
+    outnum_samples = num_samples;
+    outnum_dropped = num_dropped.load();
+
+    // Fold root first; return addresses point after the call, so step back one byte to land in the caller's line
+    std::unordered_map<void *, std::string> symbol_cache;
+    std::map<std::string, uint64_t> folded_counts;
+    for (size_t sample_idx = 0; sample_idx < num_samples; sample_idx++) {
+      auto &sample = samples[sample_idx];
+      std::string stack;
+      for (int frame_idx = sample._num_frames - 1; frame_idx >= SKIPPED_FRAMES; frame_idx--) {
+        auto address = static_cast<char *>(sample._frames[frame_idx]) - (frame_idx > SKIPPED_FRAMES ? 1 : 0);
+        auto symbol_iter = symbol_cache.find(address);
+        if (symbol_iter == symbol_cache.end()) symbol_iter = symbol_cache.emplace(address, symbolize(address)).first;
+        if (!stack.empty()) stack.push_back(';');
+        stack.append(symbol_iter->second);
+      }
+      if (!stack.empty()) folded_counts[stack]++;
+    }
+
+    std::ofstream out(filepath, std::ios::trunc);
+    if (!out) return false;
+    for (auto &[stack, count] : folded_counts) out << stack << ' ' << count << '\n';
+    return out.good();
+  }
+
+} // namespace aoc
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace aoc {
+
+  // In-process CPU sampling profiler. SIGPROF fires every 1/frequency_hz seconds of process CPU time
+  // (setitimer(ITIMER_PROF)) and the handler stores the interrupted stack (glibc backtrace) in a preallocated buffer.
+  // stop() symbolizes the samples and writes them as folded stacks ("root;caller;leaf count" per line), the input
+  // format of flamegraph.pl and speedscope. Symbols come from the dynamic symbol table, so the harness is linked with
+  // exported symbols; static and inlined functions show up under their caller or as module+offset.
+  //
+  // The timer is process wide, so only one problem may run at a time while profiling.
+  struct sampling_profiler_t {
+    int _frequency_hz = 997; // Prime, so sampling does not lock step with periodic work
+
+    sampling_profiler_t() = default;
+    ~sampling_profiler_t();
+
+    sampling_profiler_t(const sampling_profiler_t &) = delete;
+    sampling_profiler_t &operator=(const sampling_profiler_t &) = delete;
+
+    bool start();
+    // Stops sampling and writes the folded stacks to filepath. Returns false if the file cannot be written.
+    bool stop(const std::string &filepath, uint64_t &outnum_samples, uint64_t &outnum_dropped);
+
+  private:
+    bool _running = false;
+  };
+
+} // namespace aoc
@@ -0,0 +1,174 @@
+#include "scaling.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <unistd.h>
+
+#include "input_generator.h"
+#include "input_registry.h"
+#include "mapped_file.h"
+#include "output_sink.h"
+
+namespace aoc {
+
+  namespace {
+
+    struct complexity_class_t {
+      const char *_name;
+      double (*_log_cost)(double size);
+    };
+
+    const complexity_class_t COMPLEXITY_CLASSES[] = {
+        {"O(1)", [](double) { return 0.0; }},
+        {"O(log n)", [](double n) { return std::log(std::log2(n + 1)); }},
+        {"O(n)", [](double n) { return std::log(n); }},
+        {"O(n log n)", [](double n) { return std::log(n) + std::log(std::log2(n + 1)); }},
+        {"O(n^2)", [](double n) { return 2 * std::log(n); }},
+        {"O(n^2 log n)", [](double n) { return 2 * std::log(n) + std::log(std::log2(n + 1)); }},
+        {"O(n^3)", [](double n) { return 3 * std::log(n); }},
+    };
+
+    bool write_input(const std::filesystem::path &data_dirpath, const problem_t &problem, uint64_t size,
+                     const scaling_options_t &options) {
+      auto day_dirpath = data_dirpath / ("day" + std::to_string(problem._day));
+      std::error_code error;
+      std::filesystem::create_directories(day_dirpath / "problem1", error);
+      std::filesystem::create_directories(day_dirpath / "problem2", error);
+      auto filepath = day_dirpath / "problem1" / "input.txt";
+      {
+        std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        if (options._replicate) {
+          auto source_filepath = "data/day" + std::to_string(problem._day) + "/problem" + std::to_string(problem._problem) + "/input.txt";
+          mapped_file_t source(source_filepath.c_str());
+          if (!source.is_valid() || source._size == 0) return false;
+          auto text = source.view();
+          for (uint64_t i = 0; i < size; i++) {
+            out.write(text.data(), text.size());
+            if (text.back() != '\n') out.put('\n');
+          }
+        } else {
+          auto generator = find_input_generator(problem._day);
+          if (generator == nullptr) return false;
+          generator_rng_t rng(options._seed);
+          generator->_generate(out, size, rng);
+        }
+        if (!out) return false;
+      }
+      std::filesystem::copy_file(filepath, day_dirpath / "problem2" / "input.txt",
+                                 std::filesystem::copy_options::overwrite_existing, error);
+      return !error;
+    }
+
+  } // namespace
+
+  scaling_fit_t fit_complexity(const std::vector<scaling_point_t> &points) {
+    scaling_fit_t fit;
+    std::vector<std::pair<double, double>> log_points; // log(size), log(ms)
+    for (auto &point : points) {
+      if (point._size > 0 && point._median_ms > 0) log_points.emplace_back(std::log(double(point._size)), std::log(point._median_ms));
+    }
+    if (log_points.size() < 2) return fit;
+
+    // Least squares slope
+    double mean_x = 0, mean_y = 0;
+    for (auto &[x, y] : log_points) {
+      mean_x += x;
+      mean_y += y;
+    }
+    mean_x /= log_points.size();
+    mean_y /= log_points.size();
+    double covariance = 0, variance = 0;
+    for (auto &[x, y] : log_points) {
+      covariance += (x - mean_x) * (y - mean_y);
+      variance += (x - mean_x) * (x - mean_x);
+    }
+    fit._exponent = variance > 0 ? covariance / variance : 0;
+
+    // Each class as time = c * f(n): fit log(c) and keep the class with the smallest squared error
+    double best_error = std::numeric_limits<double>::infinity();
+    for (auto &complexity_class : COMPLEXITY_CLASSES) {
+      double log_constant = 0;
+      for (size_t i = 0; i < log_points.size(); i++) {
+        log_constant += log_points[i].second - complexity_class._log_cost(std::exp(log_points[i].first));
+      }
+      log_constant /= log_points.size();
+      double error = 0;
+      for (size_t i = 0; i < log_points.size(); i++) {
+        auto residual = log_points[i].second - log_constant - complexity_class._log_cost(std::exp(log_points[i].first));
+        error += residual * residual;
+      }
+      if (error < best_error) {
+        best_error = error;
+        fit._complexity = complexity_class._name;
+      }
+    }
+    return fit;
+  }
+
+  bool run_scaling(
+      const problem_t &problem,
+      const scaling_options_t &options,
+      const bench_options_t &bench_options,
+      std::vector<scaling_point_t> &points
+  ) {
+    auto generator = find_input_generator(problem._day);
+    if (!options._replicate && generator == nullptr) return false;
+    uint64_t start_size = options._start_size;
+    if (start_size == 0) start_size = options._replicate ? 1 : generator->_puzzle_scale;
+
+    auto work_dirpath = std::filesystem::temp_directory_path() / ("aoc_scaling_" + std::to_string(::getpid()));
+    auto previous_verbosity = get_verbosity();
+    set_verbosity(VERBOSITY_Quiet);
+    auto &registry = get_input_registry();
+    bool ok = true;
+
+    double size = double(start_size);
+    for (int step = 0; step < options._steps; step++, size *= options._factor) {
+      auto step_size = uint64_t(std::llround(size));
+      if (!points.empty() && step_size <= points.back()._size) continue;
+      auto data_dirpath = work_dirpath / ("step" + std::to_string(step)) / "data";
+      if (!write_input(data_dirpath, problem, step_size, options)) {
+        ok = false;
+        break;
+      }
+      // Fresh registry for every size, so nothing is served from an earlier step's cache
+      registry.clear();
+      registry.set_data_root(data_dirpath.string());
+      auto result = run_benchmark(problem._day, problem._problem, problem._logic, bench_options);
+      registry.set_data_root("");
+      registry.clear();
+      std::error_code error;
+      std::filesystem::remove_all(data_dirpath.parent_path(), error);
+
+      points.push_back({step_size, result._wall_ms._median});
+      if (result._wall_ms._max > options._max_run_ms) break;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(work_dirpath, error);
+    set_verbosity(previous_verbosity);
+    return ok;
+  }
+
+  void print_scaling_report(std::ostream &out, const problem_t &problem, const std::vector<scaling_point_t> &points, const scaling_fit_t &fit) {
+    std::ostringstream text;
+    text << "Day " << problem._day << " - Problem " << problem._problem << " scaling" << std::endl;
+    text << std::fixed << std::setprecision(3);
+    for (auto &point : points) {
+      text << "  size " << std::setw(12) << point._size << "  median " << std::setw(12) << point._median_ms << " ms" << std::endl;
+    }
+    if (points.size() >= 2) {
+      text << std::setprecision(2) << "  empirical exponent " << fit._exponent << "  closest to " << fit._complexity << std::endl;
+    } else {
+      text << "  not enough points to fit" << std::endl;
+    }
+    out << text.str() << std::flush;
+  }
+
+} // namespace aoc
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "scheduler.h"
+
+namespace aoc {
+
+  struct scaling_options_t {
+    bool _replicate = false;    // Concatenate copies of the real input instead of generating inputs
+    int _steps = 6;
+    double _factor = 2;         // Size ratio between consecutive steps
+    uint64_t _start_size = 0;   // 0: the puzzle's own size (generated) or one copy (replicated)
+    double _max_run_ms = 10000; // Stop growing once a single run takes longer than this
+    uint64_t _seed = 2019;
+  };
+
+  struct scaling_point_t {
+    uint64_t _size = 0;
+    double _median_ms = 0;
+  };
+
+  struct scaling_fit_t {
+    double _exponent = 0;     // Slope of log(time) over log(size)
+    std::string _complexity;  // Closest of O(1), O(log n), O(n), O(n log n), O(n^2), O(n^2 log n), O(n^3)
+  };
+
+  scaling_fit_t fit_complexity(const std::vector<scaling_point_t> &points);
+
+  // Runs problem over a geometric series of input sizes. Each size is written under a temporary data root (both
+  // problem1 and problem2 paths) that the input registry redirects the solver's data/ paths to. Times are the median
+  // wall time of bench_options._repetitions runs after _warmup runs. Returns false if the day has no generator (and
+  // _replicate is off) or an input could not be written.
+  bool run_scaling(
+      const problem_t &problem,
+      const scaling_options_t &options,
+      const bench_options_t &bench_options,
+      std::vector<scaling_point_t> &points
+  );
+
+  void print_scaling_report(std::ostream &out, const problem_t &problem, const std::vector<scaling_point_t> &points, const scaling_fit_t &fit);
+
+} // namespace aoc
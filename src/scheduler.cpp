@@ -0,0 +1,113 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "output_capture.h"
+
+namespace aoc {
+
+  duration_history_t read_duration_history(const std::string &filepath) {
+    // One "<day> <problem> <ms>" line per problem
+    duration_history_t history;
+    std::ifstream input_stream(filepath);
+    int day, problem;
+    double duration_ms;
+    while (input_stream >> day >> problem >> duration_ms) {
+      history[{day, problem}] = duration_ms;
+    }
+    return history;
+  }
+
+  bool write_duration_history(const std::string &filepath, const duration_history_t &history) {
+    std::ofstream output_stream(filepath, std::ios::trunc);
+    for (auto &[key, duration_ms] : history) {
+      output_stream << key.first << ' ' << key.second << ' ' << duration_ms << '\n';
+    }
+    return output_stream.good();
+  }
+
+  void run_parallel(
+      const std::vector<problem_t> &problems,
+      int num_jobs,
+      duration_history_t &history,
+      const std::function<void(const problem_t &)> &run_one
+  ) {
+    struct slot_t {
+      std::string _output;
+      double _duration_ms = 0;
+      bool _done = false;
+    };
+    std::vector<slot_t> slots(problems.size());
+
+    // Longest first. Problems without history are assumed to be long so they start early.
+    auto get_expected_duration = [&](size_t problem_idx) {
+      auto history_iter = history.find({problems[problem_idx]._day, problems[problem_idx]._problem});
+      return history_iter == history.end() ? std::numeric_limits<double>::infinity() : history_iter->second;
+    };
+    std::vector<size_t> schedule(problems.size());
+    std::iota(schedule.begin(), schedule.end(), 0);
+    std::stable_sort(schedule.begin(), schedule.end(), [&](size_t a, size_t b) {
+      return get_expected_duration(a) > get_expected_duration(b);
+    });
+
+    std::atomic<size_t> next_schedule_idx{0};
+    std::mutex mutex;
+    std::condition_variable done_condition;
+
+    auto worker = [&]() {
+      while (true) {
+        auto schedule_idx = next_schedule_idx++;
+        if (schedule_idx >= schedule.size()) return;
+        auto problem_idx = schedule[schedule_idx];
+
+        auto start = std::chrono::steady_clock::now();
+        std::string output;
+        {
+          scoped_capture_t capture;
+          run_one(problems[problem_idx]);
+          output = std::move(capture._output);
+        }
+        auto duration = std::chrono::steady_clock::now() - start;
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          auto &slot = slots[problem_idx];
+          slot._output = std::move(output);
+          slot._duration_ms = std::chrono::duration<double, std::milli>(duration).count();
+          slot._done = true;
+        }
+        done_condition.notify_all();
+      }
+    };
+
+    auto num_threads = std::min<size_t>(std::max(num_jobs, 1), problems.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; i++) threads.emplace_back(worker);
+
+    // Emit in the original order
+    for (size_t problem_idx = 0; problem_idx < problems.size(); problem_idx++) {
+      std::string output;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_condition.wait(lock, [&]() { return slots[problem_idx]._done; });
+        output = std::move(slots[problem_idx]._output);
+      }
+      std::cout << output << std::flush;
+    }
+
+    for (auto &thread : threads) thread.join();
+    for (size_t problem_idx = 0; problem_idx < problems.size(); problem_idx++) {
+      history[{problems[problem_idx]._day, problems[problem_idx]._problem}] = slots[problem_idx]._duration_ms;
+    }
+  }
+
+} // namespace aoc
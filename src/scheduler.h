@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+
+  struct problem_t {
+    int _day = 0;
+    int _problem = 0;
+    std::function<void(void)> _logic;
+  };
+
+  // Wall time in ms of the last run of each (day, problem)
+  using duration_history_t = std::map<std::pair<int, int>, double>;
+
+  duration_history_t read_duration_history(const std::string &filepath);
+  bool write_duration_history(const std::string &filepath, const duration_history_t &history);
+
+  // Runs run_one(problem) for every problem on num_jobs threads, starting the longest ones (according to history)
+  // first. Each problem's aoc::out() output is captured into its own buffer, and the buffers are written to std::cout
+  // in the original order as soon as all earlier problems have finished. Measured durations are merged into history.
+  void run_parallel(
+      const std::vector<problem_t> &problems,
+      int num_jobs,
+      duration_history_t &history,
+      const std::function<void(const problem_t &)> &run_one
+  );
+
+} // namespace aoc
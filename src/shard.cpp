@@ -0,0 +1,179 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#include "output_capture.h"
+
+namespace aoc {
+
+  namespace {
+
+    struct partial_result_t {
+      int _day = 0;
+      int _problem = 0;
+      reduce_e _reduce = REDUCE_Sum;
+      bool _has_value = false;
+      int64_t _value = 0;
+    };
+
+    // Set once by the harness before any problem runs
+    shard_t current_shard;
+
+    std::mutex partial_results_mutex;
+    std::vector<partial_result_t> partial_results;
+
+    const char *REDUCE_NAMES[] = {"sum", "min", "max"};
+
+    bool parse_reduce(const std::string &name, reduce_e &outreduce) {
+      for (int reduce = REDUCE_Sum; reduce <= REDUCE_Max; reduce++) {
+        if (name == REDUCE_NAMES[reduce]) {
+          outreduce = static_cast<reduce_e>(reduce);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void record_partial_result(const partial_result_t &partial_result) {
+      std::lock_guard<std::mutex> lock(partial_results_mutex);
+      partial_results.push_back(partial_result);
+    }
+
+  } // namespace
+
+  bool parse_shard(const std::string &text, shard_t &outshard) {
+    std::istringstream input(text);
+    shard_t shard;
+    char separator = 0;
+    if (!(input >> shard._index >> separator >> shard._count) || separator != '/' || input.peek() != EOF) return false;
+    if (shard._count < 1 || shard._index < 0 || shard._index >= shard._count) return false;
+    outshard = shard;
+    return true;
+  }
+
+  void set_shard(const shard_t &shard) {
+    current_shard = shard;
+  }
+
+  const shard_t &get_shard() {
+    return current_shard;
+  }
+
+  void report_result(int day, int problem, reduce_e reduce, int64_t value) {
+    if (!current_shard.is_sharded()) {
+      aoc::out() << "Result : " << value << std::endl;
+      return;
+    }
+    record_partial_result({day, problem, reduce, true, value});
+    aoc::out() << "Partial result (shard " << current_shard._index << "/" << current_shard._count << ", "
+              << REDUCE_NAMES[reduce] << ") : " << value << std::endl;
+  }
+
+  void report_no_candidate(int day, int problem, reduce_e reduce) {
+    record_partial_result({day, problem, reduce, false, 0});
+    aoc::out() << "Partial result (shard " << current_shard._index << "/" << current_shard._count << ", "
+              << REDUCE_NAMES[reduce] << ") : none" << std::endl;
+  }
+
+  bool write_partial_results(const std::string &filepath) {
+    std::lock_guard<std::mutex> lock(partial_results_mutex);
+    std::ofstream output_stream(filepath, std::ios::trunc);
+    output_stream << "# shard " << current_shard._index << "/" << current_shard._count << '\n';
+    for (auto &partial_result : partial_results) {
+      output_stream << partial_result._day << ' ' << partial_result._problem << ' ' << REDUCE_NAMES[partial_result._reduce] << ' ';
+      if (partial_result._has_value) {
+        output_stream << partial_result._value << '\n';
+      } else {
+        output_stream << "-\n";
+      }
+    }
+    return output_stream.good();
+  }
+
+  bool merge_partial_results(const std::vector<std::string> &filepaths, std::ostream &out) {
+    if (filepaths.empty()) {
+      std::cerr << "ERROR: --merge-shards needs the partial result file of every shard" << std::endl;
+      return false;
+    }
+    int shard_count = 0;
+    std::set<int> shard_indices;
+    std::map<std::pair<int, int>, std::vector<partial_result_t>> results_by_problem;
+
+    for (auto &filepath : filepaths) {
+      std::ifstream input_stream(filepath);
+      std::string header_line;
+      shard_t shard;
+      if (!std::getline(input_stream, header_line) || header_line.rfind("# shard ", 0) != 0 ||
+          !parse_shard(header_line.substr(8), shard)) {
+        std::cerr << "ERROR: " << filepath << " is not a shard result file" << std::endl;
+        return false;
+      }
+      if (shard_count != 0 && shard._count != shard_count) {
+        std::cerr << "ERROR: " << filepath << " belongs to a run with " << shard._count << " shards, expected " << shard_count << std::endl;
+        return false;
+      }
+      shard_count = shard._count;
+      if (!shard_indices.insert(shard._index).second) {
+        std::cerr << "ERROR: Shard " << shard._index << " given twice" << std::endl;
+        return false;
+      }
+
+      int day, problem;
+      std::string reduce_name, value_text;
+      while (input_stream >> day >> problem >> reduce_name >> value_text) {
+        partial_result_t partial_result{day, problem};
+        if (!parse_reduce(reduce_name, partial_result._reduce)) {
+          std::cerr << "ERROR: Unknown reduction " << reduce_name << " in " << filepath << std::endl;
+          return false;
+        }
+        partial_result._has_value = value_text != "-";
+        if (partial_result._has_value) partial_result._value = std::stoll(value_text);
+        results_by_problem[{day, problem}].push_back(partial_result);
+      }
+    }
+    if (static_cast<int>(shard_indices.size()) != shard_count) {
+      std::cerr << "ERROR: Got " << shard_indices.size() << " of " << shard_count << " shards" << std::endl;
+      return false;
+    }
+
+    bool ok = true;
+    for (auto &[key, problem_results] : results_by_problem) {
+      out << "Day " << key.first << " - Problem " << key.second << std::endl;
+      if (static_cast<int>(problem_results.size()) != shard_count) {
+        out << "ERROR: Only " << problem_results.size() << " of " << shard_count << " shards ran this problem\n" << std::endl;
+        ok = false;
+        continue;
+      }
+      auto reduce = problem_results.front()._reduce;
+      bool has_value = false;
+      int64_t value = 0;
+      for (auto &partial_result : problem_results) {
+        if (!partial_result._has_value) continue;
+        if (!has_value) {
+          value = partial_result._value;
+        } else if (reduce == REDUCE_Sum) {
+          value += partial_result._value;
+        } else if (reduce == REDUCE_Min) {
+          value = std::min(value, partial_result._value);
+        } else {
+          value = std::max(value, partial_result._value);
+        }
+        has_value = true;
+      }
+      if (has_value) {
+        out << "Result : " << value << "\n" << std::endl;
+      } else {
+        out << "ERROR: No shard found a candidate\n" << std::endl;
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+} // namespace aoc
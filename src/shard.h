@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace aoc {
+
+  // Static partition of a brute-force sweep: shard _index of _count owns every item whose position in the sweep
+  // order is congruent to _index. Shards need no coordination, so they can run as separate processes or on separate
+  // machines and their partial results are merged afterwards.
+  struct shard_t {
+    int _index = 0;
+    int _count = 1;
+
+    bool is_sharded() const { return _count > 1; }
+    bool owns(uint64_t item_idx) const { return static_cast<int>(item_idx % _count) == _index; }
+  };
+
+  // Parses "i/N" with 0 <= i < N
+  bool parse_shard(const std::string &text, shard_t &outshard);
+
+  void set_shard(const shard_t &shard);
+  const shard_t &get_shard();
+
+  // How the partial results of all shards combine into the answer
+  enum reduce_e {
+    REDUCE_Sum = 0,
+    REDUCE_Min,
+    REDUCE_Max,
+  };
+
+  // Prints "Result : value" when not sharded. When sharded, records value as this shard's partial result instead
+  // (written by write_partial_results) and prints it as such.
+  void report_result(int day, int problem, reduce_e reduce, int64_t value);
+  // A sharded min/max sweep in which this shard found no candidate
+  void report_no_candidate(int day, int problem, reduce_e reduce);
+
+  // One "<day> <problem> <sum|min|max> <value|->" line per recorded partial result, after a "# shard i/N" header
+  bool write_partial_results(const std::string &filepath);
+
+  // Combines the partial result files of all N shards of a run and prints one result per problem. Fails if the files
+  // do not cover every shard exactly once or disagree on the shard count.
+  bool merge_partial_results(const std::vector<std::string> &filepaths, std::ostream &out);
+
+} // namespace aoc
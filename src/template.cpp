@@ -4,6 +4,8 @@
 #include <fstream>
 #include <numeric>
 
+#include "output_capture.h"
+
 namespace day0 {
 
 //  void read_data(std::vector<int> &outdata, const char *filepath) {
@@ -17,7 +19,7 @@ namespace day0 {
 
 //    std::vector<int> input;
 //    read_data(input, "data/day1/problem1/input.txt");
-//    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required) << std::endl;
+//    aoc::out() << "Result : " << get_total_fuel_required(input, get_fuel_required) << std::endl;
   }
 
   void problem2() {
@@ -25,7 +27,7 @@ namespace day0 {
 
 //    std::vector<int> input;
 //    read_data(input, "data/day1/problem2/input.txt");
-//    std::cout << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
+//    aoc::out() << "Result : " << get_total_fuel_required(input, get_fuel_required_recursive) << std::endl;
   }
 
 } // namespace day1
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <charconv>
+#include <string_view>
+
+#include "input_registry.h"
+
+namespace aoc {
+
+  // Zero-copy scanner over a text buffer. Views returned by the read_* functions point into the scanned buffer,
+  // so they are only valid for as long as the buffer is (e.g. the mapped_file_t being scanned).
+  struct text_scanner_t {
+    std::string_view _text;
+    size_t _cursor = 0;
+
+    explicit text_scanner_t(std::string_view text) : _text(text) {}
+
+    bool at_end() const { return _cursor >= _text.size(); }
+    char peek() const { return at_end() ? '\0' : _text[_cursor]; }
+
+    // Consumes c if it is the next character
+    bool skip(char c) {
+      if (peek() != c) return false;
+      _cursor++;
+      return true;
+    }
+
+    // Consumes literal if the remaining text starts with it
+    bool skip(std::string_view literal) {
+      if (_text.substr(_cursor, literal.size()) != literal) return false;
+      _cursor += literal.size();
+      return true;
+    }
+
+    void skip_whitespace() {
+      while (!at_end() && (_text[_cursor] == ' ' || _text[_cursor] == '\t' || _text[_cursor] == '\r')) _cursor++;
+    }
+
+    template<typename value_t>
+    bool read_int(value_t &outvalue) {
+      auto [next, error] = std::from_chars(_text.data() + _cursor, _text.data() + _text.size(), outvalue);
+      if (error != std::errc()) return false;
+      _cursor = next - _text.data();
+      return true;
+    }
+
+    // Reads up to (but not including) delimiter, or to the end of the text
+    std::string_view read_until(char delimiter) {
+      auto end = _text.find(delimiter, _cursor);
+      if (end == std::string_view::npos) end = _text.size();
+      auto token = _text.substr(_cursor, end - _cursor);
+      _cursor = end;
+      return token;
+    }
+
+    // Reads a run of letters and digits
+    std::string_view read_word() {
+      auto begin = _cursor;
+      while (!at_end()) {
+        char c = _text[_cursor];
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))) break;
+        _cursor++;
+      }
+      return _text.substr(begin, _cursor - begin);
+    }
+
+    // Reads the next line without its line terminator
+    std::string_view read_line() {
+      auto line = read_until('\n');
+      skip('\n');
+      if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+      return line;
+    }
+  };
+
+  // Calls line_handler(std::string_view) for each non-empty line of filepath, which is mapped through the input
+  // registry. Returns false if the file could not be mapped.
+  template<typename line_handler_t>
+  bool for_each_line(const char *filepath, line_handler_t line_handler) {
+    auto input = get_input_registry().find_or_load(filepath);
+    if (input == nullptr) return false;
+    text_scanner_t scanner(input->text());
+    while (!scanner.at_end()) {
+      auto line = scanner.read_line();
+      if (!line.empty()) line_handler(line);
+    }
+    return true;
+  }
+
+} // namespace aoc
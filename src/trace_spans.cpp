@@ -0,0 +1,115 @@
+#include "trace_spans.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aoc {
+
+  namespace {
+
+    struct span_event_t {
+      std::string _name;
+      int64_t _start_ns;
+      int64_t _duration_ns;
+    };
+
+    // One buffer per thread, owned here so it outlives the thread (the --jobs workers exit before the trace is
+    // written). Only the owning thread appends to _events; writers take the mutex after all workers are joined.
+    struct thread_buffer_t {
+      int _thread_id;
+      std::vector<span_event_t> _events;
+    };
+
+    std::atomic<bool> tracing{false};
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<thread_buffer_t>> buffers;
+    thread_local thread_buffer_t *current_buffer = nullptr;
+
+    int64_t now_ns() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    thread_buffer_t &get_thread_buffer() {
+      if (current_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::make_unique<thread_buffer_t>());
+        buffers.back()->_thread_id = int(buffers.size());
+        current_buffer = buffers.back().get();
+      }
+      return *current_buffer;
+    }
+
+    void write_json_string(std::ostream &out, const std::string &value) {
+      out << '"';
+      for (auto c : value) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+      }
+      out << '"';
+    }
+
+  } // namespace
+
+  bool spans_compiled_in() {
+#ifdef AOC_SPANS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void start_span_trace() {
+    tracing.store(true, std::memory_order_relaxed);
+  }
+
+  bool write_span_trace(const std::string &filepath) {
+    std::ofstream out(filepath, std::ios::trunc);
+    if (!out) return false;
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    int64_t origin_ns = INT64_MAX;
+    for (auto &buffer : buffers) {
+      for (auto &event : buffer->_events) origin_ns = std::min(origin_ns, event._start_ns);
+    }
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (auto &buffer : buffers) {
+      for (auto &event : buffer->_events) {
+        out << (first ? "\n" : ",\n") << "  {\"name\": ";
+        write_json_string(out, event._name);
+        // Complete events, timestamps in microseconds
+        out << ", \"cat\": \"aoc\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->_thread_id
+            << ", \"ts\": " << (event._start_ns - origin_ns) / 1000.0
+            << ", \"dur\": " << event._duration_ns / 1000.0 << "}";
+        first = false;
+      }
+    }
+    out << "\n]}\n";
+    return out.good();
+  }
+
+  span_t::span_t(const char *name) {
+    if (!tracing.load(std::memory_order_relaxed)) return;
+    _name = name;
+    _start_ns = now_ns();
+  }
+
+  span_t::span_t(std::string name) {
+    if (!tracing.load(std::memory_order_relaxed)) return;
+    _name = std::move(name);
+    _start_ns = now_ns();
+  }
+
+  span_t::~span_t() {
+    if (_start_ns < 0) return;
+    auto end_ns = now_ns();
+    get_thread_buffer()._events.push_back({std::move(_name), _start_ns, end_ns - _start_ns});
+  }
+
+} // namespace aoc
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped spans for Chrome trace_event export (chrome://tracing, Perfetto). Mark a phase with
+//   AOC_SPAN("parse");
+// which records from that line to the end of the enclosing scope. Spans are compiled in only with AOC_SPANS
+// (-DAOC_SPANS=ON); otherwise AOC_SPAN expands to nothing. When compiled in, a span costs one relaxed atomic load
+// unless a trace was started with start_span_trace().
+
+namespace aoc {
+
+  bool spans_compiled_in();
+
+  void start_span_trace();
+  // Writes every span recorded so far (all threads) as a trace_event JSON file
+  bool write_span_trace(const std::string &filepath);
+
+  struct span_t {
+    std::string _name;
+    int64_t _start_ns = -1; // -1 when tracing was off at construction
+
+    explicit span_t(const char *name);
+    explicit span_t(std::string name);
+    ~span_t();
+
+    span_t(const span_t &) = delete;
+    span_t &operator=(const span_t &) = delete;
+  };
+
+} // namespace aoc
+
+#ifdef AOC_SPANS
+#define AOC_SPAN_CONCAT_INNER(a, b) a##b
+#define AOC_SPAN_CONCAT(a, b) AOC_SPAN_CONCAT_INNER(a, b)
+#define AOC_SPAN(name) ::aoc::span_t AOC_SPAN_CONCAT(aoc_span_, __LINE__)(name)
+#else
+#define AOC_SPAN(name) static_cast<void>(0)
+#endif